@@ -10,6 +10,38 @@ void Control::Draw(cvec2i& position, const graphicsObject& obj)
 	DrawChildren(position, obj);
 }
 
+void Control::Render(cvec2i& position, const graphicsObject& obj)
+{
+	if (!cached)
+	{
+		Draw(position, obj);
+		return;
+	}
+	if (!cache || cache->width != rect.w || cache->height != rect.h)
+	{
+		if (cache)
+		{
+			cache->DeleteColors();
+			delete cache;
+		}
+		cache = new graphicsObject(rect.w, rect.h, false);
+		cachevalid = false;
+	}
+	if (!cachevalid)
+	{
+		//before drawing, so the control can invalidate itself while it draws
+		cachevalid = true;
+		cache->ClearColor(colorPalette::transparent);
+		Draw(cvec2i(0, 0), *cache);
+	}
+	rectangle2i target = rectangle2i(position, rect.size);
+	target.crop(obj.getDrawRect());
+	if (target.w > 0 && target.h > 0)
+	{
+		obj.fillTextureCropped(target, cache->width, cache->colors + (target.x - position.x) + (target.y - position.y) * cache->width);
+	}
+}
+
 void Control::drawBorder(cvec2i& position, const graphicsObject& obj)
 {
 	obj.fillRectangle(rectangle2i(position.x, position.y, rect.size.x, borderSize), borderColor);
@@ -25,16 +57,23 @@ void Control::drawBackGround(cvec2i& position, const graphicsObject& obj)
 
 void Control::drawText(cvec2i& position, const graphicsObject& obj)
 {
-	currentFont->DrawString(text, rectangle2(rectangle2i(position,rect.size).expanded(-borderSize)), obj);
+	crectangle2 textRect = rectangle2(rectangle2i(position,rect.size).expanded(-borderSize));
+	if (!layout.isValid(*currentFont, text, textRect.size))
+	{
+		layout.Layout(*currentFont, text, textRect.size);
+	}
+	layout.Draw(*currentFont, textRect.pos00, obj);
 }
 
 void Control::DrawChildren(cvec2i& position, const graphicsObject& obj)
 {
+	crectangle2i drawrect = obj.getDrawRect();
 	for (Control* element : *childs)
 	{
-		if (element->visible)
+		//children outside the part that is being drawn are skipped
+		if (element->visible && drawrect.intersects(rectangle2i(position + element->rect.pos00, element->rect.size)))
 		{
-			element->Draw(position + element->rect.pos00, obj);
+			element->Render(position + element->rect.pos00, obj);
 		}
 	}
 }
@@ -91,6 +130,11 @@ void Control::onHover(cvec2i& position)
 	{
 		hover(position);
 	}
+	Control* highest = highestChild(position);
+	if (highest)
+	{
+		highest->onHover(position - highest->rect.pos00);
+	}
 }
 void Control::onMouseDown(cvec2i& position)
 {
@@ -151,11 +195,98 @@ void Control::destruct()
 {
 	childs->destruct();
 	delete childs;
+	delete childgrid;
+	if (cache)
+	{
+		cache->DeleteColors();
+		delete cache;
+	}
+}
+
+
+void Control::Invalidate(crectangle2i& region)
+{
+	cachevalid = false;
+	if (parent)
+	{
+		parent->Invalidate(rectangle2i(region.pos00 + rect.pos00, region.size));
+	}
+}
+
+void Control::Invalidate()
+{
+	Invalidate(rectangle2i(rect.size));
 }
 
+void Control::addChild(Control* child)
+{
+	child->parent = this;
+	childs->push_back(child);
+	childs->update();
+	childgridvalid = false;
+	child->Invalidate();
+}
+
+void Control::removeChild(Control* child)
+{
+	cint index = childs->find(child);
+	if (index >= 0)
+	{
+		child->Invalidate();
+		childs->erase(index);
+		childs->update();
+		childgridvalid = false;
+		child->parent = nullptr;
+	}
+}
+
+void Control::setRect(crectangle2i& newRect)
+{
+	//the old and the new area
+	Invalidate();
+	rect = newRect;
+	Invalidate();
+	if (parent && parent->childgrid && parent->childgridvalid)
+	{
+		cint index = parent->childs->find(this);
+		if (index >= 0 && !parent->childgrid->move(index, rect))
+		{
+			parent->childgridvalid = false;
+		}
+	}
+}
+
+void Control::setText(const std::wstring& text)
+{
+	if (this->text != text)
+	{
+		this->text = text;
+		Invalidate();
+	}
+}
 
 Control* Control::highestChild(cvec2i& pos)
 {
+	if (childs->size >= childgridminimum)
+	{
+		if (!childgrid)
+		{
+			childgrid = new rectangleGrid();
+		}
+		//childs can also be added to the list directly
+		if (!childgridvalid || (int)childgrid->rects.size() != childs->size)
+		{
+			std::vector<rectangle2i> rects = std::vector<rectangle2i>(childs->size);
+			for (int index = 0; index < childs->size; index++)
+			{
+				rects[index] = (*childs)[index]->rect;
+			}
+			childgrid->build(rects);
+			childgridvalid = true;
+		}
+		cint index = childgrid->find(pos);
+		return index >= 0 ? (*childs)[index] : nullptr;
+	}
 	//loop through childs from back to front
 	for (int index = childs->size - 1; index >= 0; index--)
 	{
@@ -3,6 +3,7 @@
 #include "brushes.h"
 #include "interaction.h"
 #include "fastlist.h"
+#include "rectanglegrid.h"
 
 struct theme
 {
@@ -19,6 +20,9 @@ struct theme
 extern theme* defaultTheme;
 
 #pragma once
+//the amount of childs a control needs before highestChild uses a grid
+constexpr int childgridminimum = 0x10;
+
 struct Control:IDestructable
 {
 public:
@@ -42,6 +46,8 @@ public:
 	//function invokers
 	//position includes the position of this element
 	virtual void Draw(cvec2i& position, const graphicsObject& obj);
+	//draws the control, or copies its offscreen surface when it is cached
+	void Render(cvec2i& position, const graphicsObject& obj);
 	virtual void drawBorder(cvec2i& position, const graphicsObject& obj);
 	virtual void drawBackGround(cvec2i& position, const graphicsObject& obj);
 	virtual void drawText(cvec2i& position, const graphicsObject& obj);
@@ -60,6 +66,19 @@ public:
 
 	virtual void destruct() override;
 
+	//marks a region of this control to be drawn again. region is relative to this control.
+	//the form merges the regions of all its controls. call this after changing a field that changes how the control looks.
+	virtual void Invalidate(crectangle2i& region);
+	//marks the whole control to be drawn again
+	void Invalidate();
+	//adds a child control and makes this control its parent
+	void addChild(Control* child);
+	void removeChild(Control* child);
+	//moves or resizes the control. change rect with this function, so the grid of the parent stays up to date.
+	void setRect(crectangle2i& newRect);
+	//sets the text and marks the control when the text changed
+	void setText(const std::wstring& text);
+
 	//raycasts from top to bottom to check which child is hit
 	Control* highestChild(cvec2i& pos);
 
@@ -75,14 +94,28 @@ public:
 	//pointer to the child that has the focus
 	Control* focusedChild = nullptr;
 	fastlist<Control*>* childs = nullptr;
+	//the rectangles of the childs by position, for highestChild. used when there are at least childgridminimum childs.
+	rectangleGrid* childgrid = nullptr;
+	//false when childs were added or removed since the grid was built
+	bool childgridvalid = false;
 
 	font* currentFont = nullptr;
 
 	std::wstring text = L"";
+	//the layout of text, made again when text, the font size or the size of the control changes
+	textLayout layout = textLayout();
 	int borderSize = 2;
 
 	color backGroundColor = colorPalette::black;
 	color borderColor = colorPalette::gray;
+
+	//draw the control and its children to an offscreen surface once, and copy that surface until the control is invalidated.
+	//for controls that rarely change. transparent pixels of the surface are not copied.
+	bool cached = false;
+	//the offscreen surface of a cached control, created when it is drawn
+	graphicsObject* cache = nullptr;
+	//if the surface shows the control as it is now
+	bool cachevalid = false;
 };
 //extern std::vector<Control*> Controls;
 
@@ -52,8 +52,17 @@
 #define RANDCOLOR (color(byte(rand()),byte(rand()),byte(rand())))
 
 //not changing types, but make it easier to type every time.
-typedef long double fp;//a floating point precision-value, precision can be fp(4 bytes), fp(8 bytes, fp 4 = 8), or long fp(16 bytes).
+//a floating point precision-value, precision can be float(4 bytes), double(8 bytes) or long double(8 or 16 bytes).
+//select it at build time by defining FP_FLOAT or FP_DOUBLE. without a definition, long double is used.
+#if defined(FP_FLOAT)
+typedef float fp;
+#elif defined(FP_DOUBLE)
+typedef double fp;
+#else
+typedef long double fp;
+#endif
 typedef long long ll;
+typedef unsigned long long ull;
 typedef unsigned char byte;
 typedef unsigned int uint;
 typedef unsigned short ushort;
@@ -22,6 +22,23 @@ constexpr int BinarySequence[]
 	0b10000000000,//1024
 };
 
+//how a texture stores its colors, so renderers can read them without calling getColor
+enum textureLayout
+{
+	layoutCustom,//only getColor can be used
+	layoutLinear,//colors[x + y * width]
+	layoutMipmapped,//the levels of a squaretex
+	layoutMipmappedMorton,//the levels of a squaretex, every level in z-order (getMortonIndex)
+};
+
+//how the 3d fill functions read the colors between texels
+enum textureFilter
+{
+	filterNearest,//the texel the coordinate is in
+	filterBilinear,//blend the 4 texels around the coordinate
+	filterTrilinear,//blend bilinear samples of the 2 mip levels closest to the size of a pixel. textures without mip levels are filtered bilinear.
+};
+
 //width and height MUST be a power of 2
 //https://en.wikipedia.org/wiki/Texture_mapping
 struct Texture:public brush,IDestructable
@@ -33,7 +50,11 @@ public:
 	int height = 0;
 	//contains the colors of this object
 	color* colors = nullptr;
+	//can be changed between draw calls
+	textureFilter filter = filterNearest;
 	virtual color getColor(const vec2& pos) const override;
+	//override this when getColor reads the colors in one of the known layouts
+	virtual textureLayout getLayout() const { return layoutCustom; }
 	static void Barycentric(const vec2& p, const vec2& a, const vec2& b, const vec2& c, fp& u, fp& v, fp& w);
 
 	static mat3x3 GetBarycentricSet(const vec2& a, const vec2& b, const vec2& c);
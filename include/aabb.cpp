@@ -0,0 +1,48 @@
+#include "aabb.h"
+
+AABB AABB::fromVertices(const bufferobject<fp>* vertices)
+{
+	if (vertices->stepcount == 0)
+	{
+		return AABB();
+	}
+	vec3 lowest = *(vec3*)vertices->buffer, highest = lowest;
+	for (int i = 1; i < vertices->stepcount; i++)
+	{
+		cvec3& vertex = *(vec3*)&(*vertices)[i];
+		for (int axis = 0; axis < 3; axis++)
+		{
+			lowest.axis[axis] = math::minimum(lowest.axis[axis], vertex.axis[axis]);
+			highest.axis[axis] = math::maximum(highest.axis[axis], vertex.axis[axis]);
+		}
+	}
+	return AABB(lowest, highest - lowest);
+}
+
+AABB AABB::combine(const AABB& a, const AABB& b)
+{
+	vec3 lowest, highest;
+	cvec3 a11 = a.pos11(), b11 = b.pos11();
+	for (int axis = 0; axis < 3; axis++)
+	{
+		lowest.axis[axis] = math::minimum(a.pos00.axis[axis], b.pos00.axis[axis]);
+		highest.axis[axis] = math::maximum(a11.axis[axis], b11.axis[axis]);
+	}
+	return AABB(lowest, highest - lowest);
+}
+
+AABB AABB::transformed(const mat4x4& transform) const
+{
+	vec3 lowest, highest;
+	for (int corner = 0; corner < 8; corner++)
+	{
+		cvec3 cornerpos = pos00 + size * vec3(corner & 1 ? 1 : 0, corner & 2 ? 1 : 0, corner & 4 ? 1 : 0);
+		cvec3 transformedpos = transform.multPointMatrix(cornerpos);
+		for (int axis = 0; axis < 3; axis++)
+		{
+			lowest.axis[axis] = corner ? math::minimum(lowest.axis[axis], transformedpos.axis[axis]) : transformedpos.axis[axis];
+			highest.axis[axis] = corner ? math::maximum(highest.axis[axis], transformedpos.axis[axis]) : transformedpos.axis[axis];
+		}
+	}
+	return AABB(lowest, highest - lowest);
+}
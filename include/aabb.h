@@ -0,0 +1,26 @@
+#pragma once
+#include "mat4x4.h"
+#include "bufferobject.h"
+
+//an axis aligned bounding box
+struct AABB
+{
+	vec3 pos00;//the lowest corner
+	vec3 size;
+	inline AABB() :pos00(vec3()), size(vec3()) {}
+	inline AABB(cvec3& pos00, cvec3& size) :pos00(pos00), size(size) {}
+	inline vec3 pos11() const
+	{
+		return pos00 + size;
+	}
+	inline vec3 getCenter() const
+	{
+		return pos00 + size * 0.5;
+	}
+	//the smallest box containing the vertices
+	static AABB fromVertices(const bufferobject<fp>* vertices);
+	//the smallest box containing both boxes
+	static AABB combine(const AABB& a, const AABB& b);
+	//the smallest box containing the 8 transformed corners of this box
+	AABB transformed(const mat4x4& transform) const;
+};
@@ -0,0 +1,49 @@
+#include "animation.h"
+
+void angleAnimation::addTrack(const animationTrack<fp>* track, bodypart* part, cint& rotationindex)
+{
+	tracks.push_back(track);
+	angles.push_back(&part->rotations[rotationindex].angle);
+	changedflags.push_back(&part->changed);
+	cursors.push_back(0);
+}
+
+void angleAnimation::addTrack(const animationTrack<fp>* track, bodyPart2D* part)
+{
+	tracks.push_back(track);
+	angles.push_back(&part->angle);
+	changedflags.push_back(&part->changed);
+	cursors.push_back(0);
+}
+
+void angleAnimation::apply(cfp& location)
+{
+	for (int i = 0; i < (int)tracks.size(); i++)
+	{
+		*angles[i] = tracks[i]->GetValue(location, cursors[i]);
+		*changedflags[i] = true;
+	}
+}
+
+void applyAnimations(angleAnimation* const* animations, const fp* locations, cint& count)
+{
+	cint jobcount = (count + animationjobsize - 1) / animationjobsize;
+	if (rendersettings::s3d::threadcount > 1 && jobcount > 1)
+	{
+		getThreadPool(rendersettings::s3d::threadcount)->run(jobcount, [animations, locations, count](cint& index)
+			{
+				cint end = min((index + 1) * animationjobsize, count);
+				for (int i = index * animationjobsize; i < end; i++)
+				{
+					animations[i]->apply(locations[i]);
+				}
+			});
+	}
+	else
+	{
+		for (int i = 0; i < count; i++)
+		{
+			animations[i]->apply(locations[i]);
+		}
+	}
+}
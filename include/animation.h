@@ -0,0 +1,157 @@
+#pragma once
+#include "keyframe.h"
+#include "bodypart.h"
+#include "bodypart2d.h"
+
+//keyframes stored next to each other, sorted by location.
+//a cursor remembers the keyframes sampled last, so playing forward rarely has to search,
+//and a track can be baked into values at a fixed rate, so sampling it does not search at all.
+template<typename t>
+struct animationTrack
+{
+	std::vector<fp> locations;
+	std::vector<t> values;
+	//the values at a fixed rate from the first to the last location, empty when the track is not baked
+	std::vector<t> baked;
+	fp bakedrate = 0;
+
+	inline animationTrack() {}
+	inline animationTrack(const transition<t>& keyframes)
+	{
+		for (const keyframe<t>* key : *keyframes.keyframes)
+		{
+			locations.push_back(key->location);
+			values.push_back(key->value);
+		}
+	}
+	//keeps the keyframes sorted. removes the baked values.
+	inline void addKeyframe(cfp& location, const t& value)
+	{
+		cint index = (int)(std::upper_bound(locations.begin(), locations.end(), location) - locations.begin());
+		locations.insert(locations.begin() + index, location);
+		values.insert(values.begin() + index, value);
+		baked.clear();
+	}
+	inline int size() const
+	{
+		return (int)locations.size();
+	}
+	//the index of the last keyframe before location, clamped so a keyframe comes after it.
+	//cursor: the result of the last search, it is tried first and then updated.
+	inline int findSegment(cfp& location, int& cursor) const
+	{
+		cint last = size() - 2;
+		//without 2 keyframes there is no segment
+		if (last < 0)
+		{
+			cursor = 0;
+			return 0;
+		}
+		if (cursor < 0 || cursor > last)
+		{
+			cursor = 0;
+		}
+		//usually the location is in the same or the next segment as last time
+		if (locations[cursor] < location)
+		{
+			if (cursor == last || location <= locations[cursor + 1])
+			{
+				return cursor;
+			}
+			if (cursor + 1 == last || location <= locations[cursor + 2])
+			{
+				return ++cursor;
+			}
+		}
+		cint index = (int)(std::lower_bound(locations.begin(), locations.end(), location) - locations.begin()) - 1;
+		cursor = math::minimum(math::maximum(index, 0), last);
+		return cursor;
+	}
+	//the same value as transition::GetValue
+	inline t GetValue(cfp& location, int& cursor) const
+	{
+		if (size() == 0)
+		{
+			return t();
+		}
+		if (location <= locations[0])
+		{
+			return values[0];
+		}
+		//at the last location, the first of the keyframes there is used, like transition does
+		if (location > locations[size() - 1])
+		{
+			return values[size() - 1];
+		}
+		if (baked.size())
+		{
+			cfp position = (location - locations[0]) * bakedrate;
+			cint index = math::minimum((int)position, (int)baked.size() - 2);
+			return lerp(baked[index], baked[index + 1], position - index);
+		}
+		cint index = findSegment(location, cursor);
+		cfp weight = getw(locations[index], locations[index + 1], location);
+		return lerp(values[index], values[index + 1], weight);
+	}
+	inline t GetValue(cfp& location) const
+	{
+		int cursor = 0;
+		return GetValue(location, cursor);
+	}
+	//stores the values at rate samples per unit of location.
+	//keyframes between samples are smoothed out, so use a rate that matches the keyframes.
+	inline void Bake(cfp& rate)
+	{
+		baked.clear();
+		bakedrate = 0;
+		if (size() < 2)
+		{
+			return;
+		}
+		cint samplecount = (int)ceil((locations[size() - 1] - locations[0]) * rate) + 1;
+		std::vector<t> samples = std::vector<t>(samplecount);
+		int cursor = 0;
+		for (int i = 0; i < samplecount; i++)
+		{
+			samples[i] = GetValue(locations[0] + i / rate, cursor);
+		}
+		//at least 2 samples, so there is always a sample after a location
+		if (samplecount < 2)
+		{
+			samples.push_back(samples[0]);
+		}
+		baked = samples;
+		bakedrate = rate;
+	}
+};
+
+//samples count tracks at once. cursors: a cursor for every track, kept between calls.
+template<typename t>
+inline void sampleTracks(const animationTrack<t>* const* tracks, const fp* locations, int* cursors, t* out, cint& count)
+{
+	for (int i = 0; i < count; i++)
+	{
+		out[i] = tracks[i]->GetValue(locations[i], cursors[i]);
+	}
+}
+
+//an animation of the angles of bodypart rotations and bodyPart2D's.
+//the angles are written directly and the parts are marked as changed, so their transforms are recalculated when they are drawn.
+struct angleAnimation
+{
+	std::vector<const animationTrack<fp>*> tracks;
+	std::vector<fp*> angles;
+	std::vector<bool*> changedflags;
+	std::vector<int> cursors;
+	//the track is not copied. the rotations of the part can not be added or removed while it is animated.
+	void addTrack(const animationTrack<fp>* track, bodypart* part, cint& rotationindex);
+	void addTrack(const animationTrack<fp>* track, bodyPart2D* part);
+	void apply(cfp& location);
+};
+
+//the least amount of animations applyAnimations gives each thread at once
+constexpr int animationjobsize = 0x40;
+
+//applies many animations, for example of a crowd of characters, split over the renderer threads.
+//locations: the location for every animation
+void applyAnimations(angleAnimation* const* animations, const fp* locations, cint& count);
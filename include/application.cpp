@@ -12,17 +12,35 @@ int application::run(form* (*initializeForm)(crectangle2i& rect), HINSTANCE hIns
 	//initialize form
 	mainForm = initializeForm(graphics->getClientRect());
 
+	//the biggest arena a frame needed until now
+	size_t arenapeak = 0;
 	while (DoEvents())//next frame
 	{
 		processInput();//process events from user
 		// Do stuff with graphics->colors
-		draw();
-		// Draw graphics->colors to window
-		BitBlt(wndDC, 0, 0, graphics->width, graphics->height, hdcMem, 0, 0, SRCCOPY);
+		const std::vector<rectangle2i> changed = draw();
+		if (changed.size())
+		{
+			// Draw the changed parts of graphics->colors to window
+			present(changed);
+		}
+		else
+		{
+			//nothing changed, so sleep until there is input
+			MsgWaitForMultipleObjects(0, NULL, FALSE, idlewaittime, QS_ALLINPUT);
+		}
+		//report when a frame needed more arena memory than before, to size the arena with
+		const size_t framepeak = graphics->EndArenaFrame();
+		if (framepeak > arenapeak)
+		{
+			arenapeak = framepeak;
+			output(L"frame arena peak: " + std::to_wstring(arenapeak) + L" bytes\n");
+		}
 	}
 	mainForm->destruct();
 	delete mainForm;
 	delete graphics;
+	DeleteThreadPool();
 	delete brushes::black;
 	delete brushes::white;
 	family->tex->destruct();
@@ -138,10 +156,19 @@ void application::processInput()
 	}
 }
 
-void application::draw()
+std::vector<rectangle2i> application::draw()
 {
-	graphics->ClearColor(colorPalette::black);
-	mainForm->Draw(cvec2i(0, 0), *graphics);
+	return mainForm->DrawDirty(*graphics, colorPalette::black);
+}
+
+void application::present(const std::vector<rectangle2i>& regions)
+{
+	for (crectangle2i& region : regions)
+	{
+		//the rows of the window go from top to bottom
+		cint windowy = graphics->height - region.y - region.h;
+		BitBlt(wndDC, region.x, windowy, region.w, region.h, hdcMem, region.x, windowy, SRCCOPY);
+	}
 }
 
 void application::MakeSurface(HWND hwnd)
@@ -191,7 +218,7 @@ void application::MakeSurface(HWND hwnd)
 	hdcMem = CreateCompatibleDC(wndDC);//HDC must be wndDC!! :)
 	hbmOld = (HBITMAP)SelectObject(hdcMem, hbmp);
 
-	graphics->depthbuffer = (fp*)calloc(graphics->width * graphics->height, sizeof(fp));
+	graphics->createDepthBuffer();
 }
 
 application* application::getApplicationConnected(HWND mainWindow)
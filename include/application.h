@@ -1,6 +1,9 @@
 #pragma once
 #include "form.h"
 
+//how long the application waits for input when nothing has to be drawn, in miliseconds
+constexpr DWORD idlewaittime = 0x20;
+
 struct application
 {
 	//data
@@ -20,7 +23,10 @@ struct application
 	//function pointer to initialize the form
 	int run(form* (*initializeForm)(crectangle2i& rect), HINSTANCE hInstance);
 	void processInput();
-	void draw();
+	//draws the parts of the form that changed and returns them
+	std::vector<rectangle2i> draw();
+	//copies the regions of graphics->colors to the window
+	void present(const std::vector<rectangle2i>& regions);
 	void MakeSurface(HWND hwnd);
 	static application* getApplicationConnected(HWND mainWindow);
 };
@@ -15,23 +15,81 @@ bodypart::bodypart(bodypart* parent, vec3 translate, vec3 scale, vec3 rotationce
 void bodypart::CalculateTransform()
 {
 	changed = false;
-	std::vector<mat4x4> transforms = std::vector<mat4x4>();
-	for (rotation r : rotations)
+	//the rotations in order, then the translation
+	applied = mat4x4();
+	for (const rotation& r : rotations)
 	{
-		transforms.push_back(mat4x4::rotate3d(r.axis, r.angle));
+		applied = mat4x4::cross(mat4x4::rotate3d(r.axis, r.angle), applied);
 	}
-	transforms.push_back(mat4x4::translate3d(translate));
-	applied = mat4x4::combine(transforms);
+	applied = mat4x4::cross(mat4x4::translate3d(translate), applied);
 }
 
+//all parts are cubes, so they are drawn as instances of the same cube in one call
 void bodypart::Draw(graphicsObject* obj, mat4x4 transform, const color* fill, const vec3 camera, const vec3 direction)
 {
-	bufferobject<color> c = bufferobject<color>(fill, 1, 0, 12);
+	std::vector<mat4x4> views = std::vector<mat4x4>();
+	AddCubeViews(transform, views);
+	const std::vector<color> colors = std::vector<color>(views.size(), *fill);
+	obj->DrawTrianglesInstanced(&cubevb0, &cubeibo, views.data(), colors.data(), (int)views.size());
+}
+
+void bodypart::AddCubeViews(const mat4x4& transform, std::vector<mat4x4>& views)
+{
 	if (changed)CalculateTransform();
 	mat4x4 view = mat4x4::cross(transform, applied);
-	obj->DrawTrianglesPlain(&cubevb0, &c, &cubeibo, camera, mat4x4::cross(view, scalecentre), direction);
+	views.push_back(mat4x4::cross(view, scalecentre));
 	for (bodypart* b : childs)
 	{
-		b->Draw(obj, view, fill, camera, direction);
+		b->AddCubeViews(view, views);
+	}
+}
+
+
+AABB bodypart::getBounds(const mat4x4& transform)
+{
+	if (changed)CalculateTransform();
+	mat4x4 view = mat4x4::cross(transform, applied);
+	//the cube of cubevb0 goes from 0 to 1
+	AABB bounds = AABB(vec3(), vec3(1)).transformed(mat4x4::cross(view, scalecentre));
+	for (bodypart* b : childs)
+	{
+		bounds = AABB::combine(bounds, b->getBounds(view));
+	}
+	return bounds;
+}
+
+int bodypart::AddToSkeleton(skeleton& s, std::vector<bodypart*>& parts, cint& parent)
+{
+	if (changed)CalculateTransform();
+	cint index = s.addBone(parent, applied);
+	parts.push_back(this);
+	for (bodypart* b : childs)
+	{
+		b->AddToSkeleton(s, parts, index);
+	}
+	return index;
+}
+
+void bodypart::UpdateSkeleton(skeleton& s, const std::vector<bodypart*>& parts)
+{
+	for (int i = 0; i < (int)parts.size(); i++)
+	{
+		if (parts[i]->changed)
+		{
+			parts[i]->CalculateTransform();
+			s.setLocalTransform(i, parts[i]->applied);
+		}
+	}
+	s.update();
+}
+
+void bodypart::DrawSkeleton(graphicsObject* obj, const skeleton& s, const std::vector<bodypart*>& parts, const mat4x4& transform, const color* fill)
+{
+	std::vector<mat4x4> views = std::vector<mat4x4>(parts.size());
+	for (int i = 0; i < (int)parts.size(); i++)
+	{
+		views[i] = mat4x4::cross(mat4x4::cross(transform, s.worldtransforms[i]), parts[i]->scalecentre);
 	}
+	const std::vector<color> colors = std::vector<color>(views.size(), *fill);
+	obj->DrawTrianglesInstanced(&cubevb0, &cubeibo, views.data(), colors.data(), (int)views.size());
 }
@@ -1,4 +1,5 @@
 #include "meshConstants.h"
+#include "skeleton.h"
 #pragma once
 struct rotation
 {
@@ -22,4 +23,14 @@ struct bodypart
 	bodypart(bodypart* parent = nullptr, vec3 translate = vec3(), vec3 scale = vec3(1), vec3 rotationcentre = vec3(0.5), std::initializer_list<rotation> rotations = {}, std::initializer_list<bodypart*> childs = {});
 	void CalculateTransform();
 	void Draw(graphicsObject* obj, mat4x4 transform, const color* fill, const vec3 camera, const vec3 direction);
+	//adds the view matrix of the cube of this part and its children
+	void AddCubeViews(const mat4x4& transform, std::vector<mat4x4>& views);
+	//the box around this part and its children, in the space transform converts to
+	AABB getBounds(const mat4x4& transform);
+	//adds this part and its children to a skeleton, parts get the same indexes as their bones
+	int AddToSkeleton(skeleton& s, std::vector<bodypart*>& parts, cint& parent = -1);
+	//copies the transforms of the changed parts to their bones and updates the skeleton
+	static void UpdateSkeleton(skeleton& s, const std::vector<bodypart*>& parts);
+	//draws the cubes of all parts with the world transforms of an updated skeleton
+	static void DrawSkeleton(graphicsObject* obj, const skeleton& s, const std::vector<bodypart*>& parts, const mat4x4& transform, const color* fill);
 };
\ No newline at end of file
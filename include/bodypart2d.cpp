@@ -17,14 +17,12 @@ bodyPart2D::bodyPart2D(crectangle2i& textureRect, bodyPart2D* parent, vec2 trans
 void bodyPart2D::CalculateTransform()
 {
 	changed = false;
-
-	std::vector<mat3x3> transforms = std::vector<mat3x3>();
+	applied = mat3x3::translate2d(translate);
 	if (angle != 0) 
 	{
-		transforms.push_back(mat3x3::rotate2d(angle));
+		//first rotate, then translate
+		applied = mat3x3::cross(applied, mat3x3::rotate2d(angle));
 	}
-	transforms.push_back(mat3x3::translate2d(translate));
-	applied = mat3x3::combine(transforms);
 }
 
 void bodyPart2D::Draw(const graphicsObject& obj, mat3x3 transform, const Texture* tex)
@@ -38,3 +36,37 @@ void bodyPart2D::Draw(const graphicsObject& obj, mat3x3 transform, const Texture
 		b->Draw(obj, view, tex);
 	}
 }
+
+int bodyPart2D::AddToSkeleton(skeleton2d& s, std::vector<bodyPart2D*>& parts, cint& parent)
+{
+	if (changed)
+		CalculateTransform();
+	cint index = s.addBone(parent, applied);
+	parts.push_back(this);
+	for (bodyPart2D* b : *childs)
+	{
+		b->AddToSkeleton(s, parts, index);
+	}
+	return index;
+}
+
+void bodyPart2D::UpdateSkeleton(skeleton2d& s, const std::vector<bodyPart2D*>& parts)
+{
+	for (int i = 0; i < (int)parts.size(); i++)
+	{
+		if (parts[i]->changed)
+		{
+			parts[i]->CalculateTransform();
+			s.setLocalTransform(i, parts[i]->applied);
+		}
+	}
+	s.update();
+}
+
+void bodyPart2D::DrawSkeleton(const graphicsObject& obj, const skeleton2d& s, const std::vector<bodyPart2D*>& parts, const mat3x3& transform, const Texture* tex)
+{
+	for (int i = 0; i < (int)parts.size(); i++)
+	{
+		obj.fillTexture(parts[i]->textureRect, mat3x3::cross(mat3x3::cross(transform, s.worldtransforms[i]), parts[i]->scalecentre), *tex);
+	}
+}
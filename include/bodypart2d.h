@@ -1,5 +1,6 @@
 #include "rectangle2.h"
 #include "graphics.h"
+#include "skeleton.h"
 #pragma once
 struct bodyPart2D
 {
@@ -18,4 +19,10 @@ struct bodyPart2D
 	bodyPart2D(crectangle2i& textureRect,bodyPart2D* parent = NULL, vec2 translate = vec2(), vec2 scale = vec2(1), vec2 rotationcentre = vec2(0.5), std::initializer_list<bodyPart2D*> childs = {}, cfp& angle = 0);
 	void CalculateTransform();
 	void Draw(const graphicsObject& obj, mat3x3 transform, const Texture* tex);
+	//adds this part and its children to a skeleton, parts get the same indexes as their bones
+	int AddToSkeleton(skeleton2d& s, std::vector<bodyPart2D*>& parts, cint& parent = -1);
+	//copies the transforms of the changed parts to their bones and updates the skeleton
+	static void UpdateSkeleton(skeleton2d& s, const std::vector<bodyPart2D*>& parts);
+	//draws all parts with the world transforms of an updated skeleton
+	static void DrawSkeleton(const graphicsObject& obj, const skeleton2d& s, const std::vector<bodyPart2D*>& parts, const mat3x3& transform, const Texture* tex);
 };
\ No newline at end of file
@@ -5,3 +5,12 @@ color brush::getColor(cvec2& pos) const
 	throw 0;//not implemented
 }
 
+
+void brush::fillSpan(cint& y, cint& x0, cint& x1, color* dst) const
+{
+	vec2 pos = vec2(x0, y);
+	for (int x = x0; x < x1; x++, pos.x++)
+	{
+		*dst++ = getColor(pos);
+	}
+}
@@ -1,6 +1,11 @@
 #include "mathfunctions.h"
 #pragma once
+//the amount of pixels brushes process at once when they need room for the colors of other brushes
+constexpr int brushspansize = 0x100;
 struct brush
 {
 	virtual color getColor(cvec2& pos) const;
+	//writes the colors of the pixels from x0 up to x1 on row y to dst.
+	//override this when a whole row can be filled faster than by calling getColor for every pixel.
+	virtual void fillSpan(cint& y, cint& x0, cint& x1, color* dst) const;
 };
\ No newline at end of file
@@ -8,6 +8,27 @@ color SolidColorBrush::getColor(cvec2& pos) const
 {
 	return c;
 }
+void SolidColorBrush::fillSpan(cint& y, cint& x0, cint& x1, color* dst) const
+{
+	std::fill(dst, dst + (x1 - x0), c);
+}
+
+void linkedBrush::readSpan(cint& y, cint& x0, cint& x1, color* dst) const
+{
+	if (rendersettings::multsize)
+	{
+		//the positions are scaled, so every pixel has to be read on its own
+		vec2 pos = vec2(x0, y);
+		for (int x = x0; x < x1; x++, pos.x++)
+		{
+			*dst++ = g->getColor(pos);
+		}
+	}
+	else
+	{
+		memmove(dst, g->colors + x0 + y * g->width, (x1 - x0) * sizeof(color));
+	}
+}
 
 color saturator::getColor(cvec2& pos) const
 {
@@ -18,12 +39,41 @@ color saturator::getColor(cvec2& pos) const
 	cvec3 rgbSaturated = hsv2rgb(saturated);
 	return vectocolor(rgbSaturated);
 }
+void saturator::fillSpan(cint& y, cint& x0, cint& x1, color* dst) const
+{
+	readSpan(y, x0, x1, dst);
+	color* const end = dst + (x1 - x0);
+	for (color* ptr = dst; ptr < end; ptr++)
+	{
+		cvec3 hsv = rgb2hsv(colortovec(*ptr));
+		*ptr = vectocolor(hsv2rgb(vec3(hsv.h, math::minimum(hsv.s + addsaturation, (fp)1.0), math::minimum(hsv.v + addvalue, (fp)1.0))));
+	}
+}
 color colorMultiplier::getColor(cvec2& pos) const
 {
 	const color original = g->getColor(pos);
 
 	return original * multColors;
 }
+void colorMultiplier::fillSpan(cint& y, cint& x0, cint& x1, color* dst) const
+{
+	readSpan(y, x0, x1, dst);
+	color* const end = dst + (x1 - x0);
+	if (rendersettings::checkopacity)
+	{
+		for (color* ptr = dst; ptr < end; ptr++)
+		{
+			*ptr = multiplyLight<true>(*ptr, multColors);
+		}
+	}
+	else
+	{
+		for (color* ptr = dst; ptr < end; ptr++)
+		{
+			*ptr = multiplyLight<false>(*ptr, multColors);
+		}
+	}
+}
 
 alphaMask::alphaMask(const brush* AlphaTex, const brush* basebrush)
 {
@@ -41,11 +91,35 @@ color alphaMask::getColor(const vec2& pos) const
 	const byte alpha = AlphaTex->getColor(pos).a;
 	return color(c, alpha);
 }
+void alphaMask::fillSpan(cint& y, cint& x0, cint& x1, color* dst) const
+{
+	//the alphas are read before dst is written, so both brushes can read the pixels dst points to
+	color alphas[brushspansize];
+	for (int x = x0; x < x1; x += brushspansize)
+	{
+		cint count = min(brushspansize, x1 - x);
+		color* const chunk = dst + (x - x0);
+		AlphaTex->fillSpan(y, x, x + count, alphas);
+		basebrush->fillSpan(y, x, x + count, chunk);
+		for (int i = 0; i < count; i++)
+		{
+			chunk[i].a = alphas[i].a;
+		}
+	}
+}
 
 color functionPointerBrush::getColor(const vec2& pos) const
 {
 	return functionPointer(pos);
 }
+void functionPointerBrush::fillSpan(cint& y, cint& x0, cint& x1, color* dst) const
+{
+	vec2 pos = vec2(x0, y);
+	for (int x = x0; x < x1; x++, pos.x++)
+	{
+		*dst++ = functionPointer(pos);
+	}
+}
 
 color colorMixer::getColor(const vec2& pos) const
 {
@@ -63,4 +137,22 @@ color colorMixer::getColor(color topColor, color bottomColor)
 	{
 		return color::transition(topColor, bottomColor);
 	}
-}
\ No newline at end of file
+}
+void colorMixer::fillSpan(cint& y, cint& x0, cint& x1, color* dst) const
+{
+	if (!rendersettings::checkopacity)
+	{
+		topBrush->fillSpan(y, x0, x1, dst);
+		return;
+	}
+	//the top colors are read before dst is written, so both brushes can read the pixels dst points to
+	color topcolors[brushspansize];
+	for (int x = x0; x < x1; x += brushspansize)
+	{
+		cint count = min(brushspansize, x1 - x);
+		color* const chunk = dst + (x - x0);
+		topBrush->fillSpan(y, x, x + count, topcolors);
+		bottomBrush->fillSpan(y, x, x + count, chunk);
+		compositeRow(chunk, topcolors, count, blendSourceOver);
+	}
+}
@@ -5,6 +5,7 @@ struct SolidColorBrush :public brush
 	color c;
 	SolidColorBrush(const color& c) :c(c) {}
 	virtual color getColor(cvec2& pos) const override;
+	virtual void fillSpan(cint& y, cint& x0, cint& x1, color* dst) const override;
 };
 
 struct linkedBrush :brush
@@ -12,6 +13,8 @@ struct linkedBrush :brush
 	//a brush linked to a graphicsObject
 	//not linked to a brush in general, because a graphicsobject contains a width, height and depthbuffer
 	const graphicsObject* g;
+	//reads the colors of g like getColor does. dst can be the same row of g.
+	void readSpan(cint& y, cint& x0, cint& x1, color* dst) const;
 };
 
 struct saturator : public linkedBrush
@@ -19,12 +22,14 @@ struct saturator : public linkedBrush
 	fp addsaturation = 0.3;
 	fp addvalue = 0.1;
 	virtual color getColor(cvec2& pos) const override;
+	virtual void fillSpan(cint& y, cint& x0, cint& x1, color* dst) const override;
 
 };
 struct colorMultiplier : public linkedBrush
 {
 	vec3 multColors;
 	virtual color getColor(cvec2& pos) const override;
+	virtual void fillSpan(cint& y, cint& x0, cint& x1, color* dst) const override;
 };
 struct alphaMask :public brush
 {
@@ -33,6 +38,7 @@ struct alphaMask :public brush
 	const brush* AlphaTex;
 	const brush* basebrush;
 	color getColor(const vec2& pos) const override;
+	virtual void fillSpan(cint& y, cint& x0, cint& x1, color* dst) const override;
 };
 struct colorMixer: public brush
 {
@@ -43,12 +49,14 @@ struct colorMixer: public brush
 	colorMixer(brush* topBrush, brush* bottomBrush):topBrush(topBrush), bottomBrush(bottomBrush){}
 	color getColor(const vec2& pos) const override;
 	static color getColor(color topColor, color bottomColor);
+	virtual void fillSpan(cint& y, cint& x0, cint& x1, color* dst) const override;
 };
 struct functionPointerBrush : public brush
 {
 	functionPointerBrush(color(*functionPointer)(const vec2& pos)):functionPointer(functionPointer){}
 	color(*functionPointer)(const vec2& pos);
 	color getColor(const vec2& pos) const override;
+	virtual void fillSpan(cint& y, cint& x0, cint& x1, color* dst) const override;
 };
 namespace brushes 
 {
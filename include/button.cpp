@@ -14,6 +14,8 @@ void button::Draw(cvec2i& position, const graphicsObject& obj)
 	if (part < 1) 
 	{
 		c = color::lerpcolor(clickColor, backGroundColor, part);
+		//the next frame shows the next step of the effect
+		Invalidate();
 	}
 	else 
 	{
@@ -28,4 +30,5 @@ void button::Draw(cvec2i& position, const graphicsObject& obj)
 void button::onClick()
 {
 	lastClickTime = getMiliseconds();
+	Invalidate();
 }
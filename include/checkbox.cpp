@@ -8,6 +8,7 @@ checkBox::checkBox(crectangle2i& rect) :Control(rect)
 void checkBox::onClick()
 {
 	checked = !checked;
+	Invalidate();
 	onCheckedChanged();
 }
 
@@ -0,0 +1,106 @@
+#include "clipping.h"
+
+fp rendersettings::s3d::guardband = 0x2000;
+bool rendersettings::s3d::perspectivecorrect = true;
+
+bool isOutsideGuardBand(const triangle& tri, cfp& width, cfp& height)
+{
+	cfp band = rendersettings::s3d::guardband;
+	for (cvec3& screen : tri.screen)
+	{
+		if (screen.x < -band || screen.x > width + band || screen.y < -band || screen.y > height + band)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+//a corner of the polygon that is clipped
+struct clipVertex
+{
+	vec3 screen;
+	vec2 t;
+	vec3 light;
+	fp w;
+};
+
+//keeps the part of the polygon where screen.axis[axis] * side <= limit * side
+//perspective: interpolate the attributes like the rasterizers do when correcting for perspective
+inline int clipPolygon(const clipVertex* in, cint& count, cint& axis, cfp& limit, cfp& side, const bool& perspective, clipVertex* out)
+{
+	int outcount = 0;
+	for (int i = 0; i < count; i++)
+	{
+		const clipVertex& current = in[i];
+		const clipVertex& next = in[(i + 1) % count];
+		const bool currentinside = current.screen.axis[axis] * side <= limit * side;
+		const bool nextinside = next.screen.axis[axis] * side <= limit * side;
+		if (currentinside)
+		{
+			out[outcount++] = current;
+		}
+		if (currentinside != nextinside)
+		{
+			cfp w = getw<fp>(current.screen.axis[axis], next.screen.axis[axis], limit);
+			clipVertex& intersection = out[outcount++];
+			intersection.screen = lerp<vec3>(current.screen, next.screen, w);
+			intersection.screen.axis[axis] = limit;
+			if (perspective)
+			{
+				//1 / w and the attributes divided by w are linear in window space
+				cfp currentinvw = 1 / current.w, nextinvw = 1 / next.w;
+				cfp invw = lerp<fp>(currentinvw, nextinvw, w);
+				intersection.w = 1 / invw;
+				intersection.t = lerp<vec2>(current.t * currentinvw, next.t * nextinvw, w) * intersection.w;
+				intersection.light = lerp<vec3>(current.light * currentinvw, next.light * nextinvw, w) * intersection.w;
+			}
+			else
+			{
+				intersection.w = lerp<fp>(current.w, next.w, w);
+				intersection.t = lerp<vec2>(current.t, next.t, w);
+				intersection.light = lerp<vec3>(current.light, next.light, w);
+			}
+		}
+	}
+	return outcount;
+}
+
+int clipToGuardBand(const triangle& in, cfp& width, cfp& height, triangle* out)
+{
+	cfp band = rendersettings::s3d::guardband;
+	//every plane adds at most 1 corner
+	clipVertex polygon[2][3 + 4];
+	for (int i = 0; i < 3; i++)
+	{
+		polygon[0][i].screen = in.screen[i];
+		polygon[0][i].t = in.t[i];
+		polygon[0][i].light = in.light[i];
+		polygon[0][i].w = in.w[i];
+	}
+	const bool perspective = isPerspectiveCorrect(in.w);
+	int count = 3;
+	int current = 0;
+	const fp limits[4] = { -band, width + band, -band, height + band };
+	for (int plane = 0; plane < 4 && count; plane++)
+	{
+		count = clipPolygon(polygon[current], count, plane / 2, limits[plane], plane % 2 ? 1 : -1, perspective, polygon[1 - current]);
+		current = 1 - current;
+	}
+	//the polygon is convex, so it can be split in a fan
+	int trianglecount = 0;
+	for (int i = 2; i < count; i++)
+	{
+		triangle& tri = out[trianglecount++];
+		cint corners[3] = { 0, i - 1, i };
+		for (int j = 0; j < 3; j++)
+		{
+			const clipVertex& corner = polygon[current][corners[j]];
+			tri.screen[j] = corner.screen;
+			tri.t[j] = corner.t;
+			tri.light[j] = corner.light;
+			tri.w[j] = corner.w;
+		}
+	}
+	return trianglecount;
+}
@@ -0,0 +1,60 @@
+#pragma once
+#include "triangle.h"
+
+namespace rendersettings
+{
+	namespace s3d
+	{
+		//how far triangles can reach outside the screen in pixels before they are clipped to it.
+		//inside the guard band, the rasterizers skip the pixels outside the screen themselves, which is cheaper than clipping.
+		extern fp guardband;
+		//interpolate texture coordinates and light linearly in view space instead of in window space.
+		//costs a division per pixel.
+		extern bool perspectivecorrect;
+	}
+}
+
+//returns true if the attributes of a triangle with these 3 clip space w's should be interpolated perspective correct.
+//when w is nullptr or a w is not positive, the vertex was not divided by it, so the attributes are interpolated linearly.
+inline bool isPerspectiveCorrect(const fp* w)
+{
+	return rendersettings::s3d::perspectivecorrect && w && w[0] > 0 && w[1] > 0 && w[2] > 0;
+}
+
+//the planes of the view frustum a vertex is outside of, a bit per plane.
+//a triangle whose vertices are all outside the same plane can not be visible.
+enum clipOutcode
+{
+	outsideLeft = 1 << 0,
+	outsideRight = 1 << 1,
+	outsideTop = 1 << 2,
+	outsideBottom = 1 << 3,
+	outsideNear = 1 << 4,//z <= 0, the vertex has to be clipped by Triangle_ClipAgainstScreen
+	outsideFar = 1 << 5,//z >= maxdistance
+};
+
+//the outcode of a vertex in window space on a screen of width by height pixels.
+//w: the clip space w of the vertex. x and y are only divided by w when it is positive, so they are only tested then.
+inline int getOutcode(cvec3& screen, cfp& w, cfp& width, cfp& height, cfp& maxdistance)
+{
+	int outcode = 0;
+	if (w > 0)
+	{
+		outcode |= screen.x < 0 ? outsideLeft : screen.x > width ? outsideRight : 0;
+		outcode |= screen.y < 0 ? outsideTop : screen.y > height ? outsideBottom : 0;
+	}
+	outcode |= screen.z <= 0 ? outsideNear : screen.z >= maxdistance ? outsideFar : 0;
+	return outcode;
+}
+
+//returns true if a vertex of the triangle is further outside the screen than the guard band
+bool isOutsideGuardBand(const triangle& tri, cfp& width, cfp& height);
+
+//the most triangles clipToGuardBand can return: a triangle clipped by 4 planes has up to 7 corners
+constexpr int maxGuardBandTriangles = 5;
+
+//clips the window space positions of the triangle to the screen expanded by the guard band.
+//the depth is interpolated linearly in window space, like the rasterizers do.
+//the texture coordinates and light are too, unless they are interpolated perspective correct.
+//out: room for maxGuardBandTriangles triangles. returns the amount of triangles written.
+int clipToGuardBand(const triangle& in, cfp& width, cfp& height, triangle* out);
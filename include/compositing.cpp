@@ -0,0 +1,225 @@
+#include "compositing.h"
+
+blendMode rendersettings::blendmode = blendCutout;
+simdKernel rendersettings::compositekernel = getBestKernel();
+
+//x / 0xff rounded, for x from 0 to 0xff * 0xff
+inline int div255(cint& x)
+{
+	cint rounded = x + 0x80;
+	return (rounded + (rounded >> 8)) >> 8;
+}
+
+template<blendMode mode>
+void compositeRowScalar(color* dst, const color* src, cint& count)
+{
+	for (int i = 0; i < count; i++)
+	{
+		const color s = src[i];
+		color& d = dst[i];
+		switch (mode)
+		{
+		case blendCopy:
+			d = s;
+			break;
+		case blendCutout:
+			if (s.a > 0)
+			{
+				d = s;
+			}
+			break;
+		case blendSourceOver:
+		{
+			//the alpha of the source is blended like a channel of 0xff, which gives the alpha of color::transition
+			cint inverse = 0xff - s.a;
+			for (int channel = 0; channel < 3; channel++)
+			{
+				d.channels[channel] = (byte)div255(s.channels[channel] * s.a + d.channels[channel] * inverse);
+			}
+			d.a = (byte)div255(0xff * s.a + d.a * inverse);
+			break;
+		}
+		case blendPremultiplied:
+		{
+			cint inverse = 0xff - s.a;
+			for (int channel = 0; channel < colorchannels; channel++)
+			{
+				d.channels[channel] = (byte)min(s.channels[channel] + div255(d.channels[channel] * inverse), 0xff);
+			}
+			break;
+		}
+		case blendAdditive:
+			for (int channel = 0; channel < colorchannels; channel++)
+			{
+				d.channels[channel] = (byte)min(s.channels[channel] + d.channels[channel], 0xff);
+			}
+			break;
+		case blendMultiply:
+			for (int channel = 0; channel < colorchannels; channel++)
+			{
+				d.channels[channel] = (byte)div255(s.channels[channel] * d.channels[channel]);
+			}
+			break;
+		}
+	}
+}
+
+//x / 0xff rounded in 16 bit lanes
+inline __m128i div255(const __m128i& x)
+{
+	const __m128i rounded = _mm_add_epi16(x, _mm_set1_epi16(0x80));
+	return _mm_srli_epi16(_mm_add_epi16(rounded, _mm_srli_epi16(rounded, 8)), 8);
+}
+
+//combines 2 pixels with 16 bits per channel
+template<blendMode mode>
+inline __m128i compositeChannels(const __m128i& src, const __m128i& dst)
+{
+	//the alpha of each pixel in all 4 channels
+	const __m128i alpha = _mm_shufflehi_epi16(_mm_shufflelo_epi16(src, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+	const __m128i inverse = _mm_sub_epi16(_mm_set1_epi16(0xff), alpha);
+	switch (mode)
+	{
+	case blendSourceOver:
+	{
+		const __m128i opaquesrc = _mm_or_si128(src, _mm_set_epi16(0xff, 0, 0, 0, 0xff, 0, 0, 0));
+		return div255(_mm_add_epi16(_mm_mullo_epi16(opaquesrc, alpha), _mm_mullo_epi16(dst, inverse)));
+	}
+	case blendPremultiplied:
+		//clamped when packing
+		return _mm_add_epi16(src, div255(_mm_mullo_epi16(dst, inverse)));
+	default:
+		return div255(_mm_mullo_epi16(src, dst));
+	}
+}
+
+//combines 4 pixels
+template<blendMode mode>
+inline __m128i compositePixels(const __m128i& src, const __m128i& dst)
+{
+	const __m128i zero = _mm_setzero_si128();
+	switch (mode)
+	{
+	case blendCopy:
+		return src;
+	case blendCutout:
+	{
+		const __m128i transparent = _mm_cmpeq_epi32(_mm_srli_epi32(src, 24), zero);
+		return _mm_or_si128(_mm_and_si128(transparent, dst), _mm_andnot_si128(transparent, src));
+	}
+	case blendAdditive:
+		return _mm_adds_epu8(src, dst);
+	default:
+		return _mm_packus_epi16(
+			compositeChannels<mode>(_mm_unpacklo_epi8(src, zero), _mm_unpacklo_epi8(dst, zero)),
+			compositeChannels<mode>(_mm_unpackhi_epi8(src, zero), _mm_unpackhi_epi8(dst, zero)));
+	}
+}
+
+template<blendMode mode>
+void compositeRowSSE2(color* dst, const color* src, cint& count)
+{
+	int i = 0;
+	for (; i + 4 <= count; i += 4)
+	{
+		const __m128i s = _mm_loadu_si128((const __m128i*)(src + i));
+		const __m128i d = _mm_loadu_si128((const __m128i*)(dst + i));
+		_mm_storeu_si128((__m128i*)(dst + i), compositePixels<mode>(s, d));
+	}
+	compositeRowScalar<mode>(dst + i, src + i, count - i);
+}
+
+inline __m256i div255(const __m256i& x)
+{
+	const __m256i rounded = _mm256_add_epi16(x, _mm256_set1_epi16(0x80));
+	return _mm256_srli_epi16(_mm256_add_epi16(rounded, _mm256_srli_epi16(rounded, 8)), 8);
+}
+
+//combines 4 pixels with 16 bits per channel, 2 in each 128 bit lane
+template<blendMode mode>
+inline __m256i compositeChannels(const __m256i& src, const __m256i& dst)
+{
+	const __m256i alpha = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(src, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+	const __m256i inverse = _mm256_sub_epi16(_mm256_set1_epi16(0xff), alpha);
+	switch (mode)
+	{
+	case blendSourceOver:
+	{
+		const __m256i opaquesrc = _mm256_or_si256(src, _mm256_set_epi16(0xff, 0, 0, 0, 0xff, 0, 0, 0, 0xff, 0, 0, 0, 0xff, 0, 0, 0));
+		return div255(_mm256_add_epi16(_mm256_mullo_epi16(opaquesrc, alpha), _mm256_mullo_epi16(dst, inverse)));
+	}
+	case blendPremultiplied:
+		return _mm256_add_epi16(src, div255(_mm256_mullo_epi16(dst, inverse)));
+	default:
+		return div255(_mm256_mullo_epi16(src, dst));
+	}
+}
+
+//combines 8 pixels. unpacking and packing stay within the 128 bit lanes, so the pixels keep their order.
+template<blendMode mode>
+inline __m256i compositePixels(const __m256i& src, const __m256i& dst)
+{
+	const __m256i zero = _mm256_setzero_si256();
+	switch (mode)
+	{
+	case blendCopy:
+		return src;
+	case blendCutout:
+	{
+		const __m256i transparent = _mm256_cmpeq_epi32(_mm256_srli_epi32(src, 24), zero);
+		return _mm256_blendv_epi8(src, dst, transparent);
+	}
+	case blendAdditive:
+		return _mm256_adds_epu8(src, dst);
+	default:
+		return _mm256_packus_epi16(
+			compositeChannels<mode>(_mm256_unpacklo_epi8(src, zero), _mm256_unpacklo_epi8(dst, zero)),
+			compositeChannels<mode>(_mm256_unpackhi_epi8(src, zero), _mm256_unpackhi_epi8(dst, zero)));
+	}
+}
+
+template<blendMode mode>
+void compositeRowAVX2(color* dst, const color* src, cint& count)
+{
+	int i = 0;
+	for (; i + 8 <= count; i += 8)
+	{
+		const __m256i s = _mm256_loadu_si256((const __m256i*)(src + i));
+		const __m256i d = _mm256_loadu_si256((const __m256i*)(dst + i));
+		_mm256_storeu_si256((__m256i*)(dst + i), compositePixels<mode>(s, d));
+	}
+	compositeRowSSE2<mode>(dst + i, src + i, count - i);
+}
+
+template<blendMode mode>
+inline compositeFunction getCompositeKernel(const simdKernel& kernel)
+{
+	switch (kernel)
+	{
+	case kernelAVX2:
+		return compositeRowAVX2<mode>;
+	case kernelSSE2:
+		return compositeRowSSE2<mode>;
+	default:
+		return compositeRowScalar<mode>;
+	}
+}
+
+compositeFunction getCompositeKernel(const blendMode& mode, const simdKernel& kernel)
+{
+	switch (mode)
+	{
+	case blendCutout:
+		return getCompositeKernel<blendCutout>(kernel);
+	case blendSourceOver:
+		return getCompositeKernel<blendSourceOver>(kernel);
+	case blendPremultiplied:
+		return getCompositeKernel<blendPremultiplied>(kernel);
+	case blendAdditive:
+		return getCompositeKernel<blendAdditive>(kernel);
+	case blendMultiply:
+		return getCompositeKernel<blendMultiply>(kernel);
+	default:
+		return getCompositeKernel<blendCopy>(kernel);
+	}
+}
@@ -0,0 +1,34 @@
+#pragma once
+#include "GlobalFunctions.h"
+#include "cpufeatures.h"
+
+//the ways a row of source pixels can be combined with the pixels under it
+enum blendMode
+{
+	blendCopy,//replace the pixels
+	blendCutout,//replace the pixels where the source alpha is above 0
+	blendSourceOver,//the source above the pixels, like color::transition
+	blendPremultiplied,//the source above the pixels, with the color channels of the source already multiplied by its alpha
+	blendAdditive,//add the channels, clamped to 0xff
+	blendMultiply,//multiply the channels, as values from 0 to 1
+};
+
+namespace rendersettings
+{
+	//how fillTexture and fillTextureCropped draw images when checkopacity is on. blendCutout by default.
+	extern blendMode blendmode;
+	//the kernel compositeRow uses. the best supported kernel by default.
+	extern simdKernel compositekernel;
+}
+
+//combines count source pixels with the pixels of dst and stores the result in dst.
+//the kernels divide by 0xff with rounding, so results can differ 1 from color::transition.
+typedef void(*compositeFunction)(color* dst, const color* src, cint& count);
+
+//the kernel of a blend mode for an instruction set
+compositeFunction getCompositeKernel(const blendMode& mode, const simdKernel& kernel);
+
+inline void compositeRow(color* dst, const color* src, cint& count, const blendMode& mode)
+{
+	getCompositeKernel(mode, rendersettings::compositekernel)(dst, src, count);
+}
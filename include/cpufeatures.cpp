@@ -0,0 +1,19 @@
+#include "cpufeatures.h"
+
+simdKernel getBestKernel()
+{
+	int info[4];
+	__cpuid(info, 0);
+	cint maxleaf = info[0];
+	__cpuid(info, 1);
+	const bool sse2 = (info[3] & (1 << 26)) != 0;
+	//avx, and the os saves the ymm registers
+	const bool avx = (info[2] & (1 << 28)) != 0 && (info[2] & (1 << 27)) != 0 && (_xgetbv(0) & 6) == 6;
+	bool avx2 = false;
+	if (avx && maxleaf >= 7)
+	{
+		__cpuidex(info, 7, 0);
+		avx2 = (info[1] & (1 << 5)) != 0;
+	}
+	return avx2 ? kernelAVX2 : sse2 ? kernelSSE2 : kernelScalar;
+}
@@ -0,0 +1,14 @@
+#pragma once
+#include "GlobalFunctions.h"
+#include <intrin.h>
+
+//the instruction sets the simd kernels can use
+enum simdKernel
+{
+	kernelScalar,//one element at a time
+	kernelSSE2,//4 floats at a time
+	kernelAVX2,//8 floats at a time
+};
+
+//the fastest kernel this processor supports
+simdKernel getBestKernel();
@@ -0,0 +1,39 @@
+#pragma once
+#include "GlobalFunctions.h"
+
+//the ways a depth buffer can store its distances
+//https://en.wikipedia.org/wiki/Z-buffering
+enum depthFormat
+{
+	depthFp,//fp per pixel, the distances themselves
+	depthFloat32,//float per pixel, the distances themselves
+	depthUnorm24,//uint per pixel, the distances from 0 to the depth range scaled to 0 to 0xffffff. the upper 8 bits are unused
+	depthUnorm32,//uint per pixel, the distances from 0 to the depth range scaled to 0 to 0xffffffff
+};
+
+//the amount of bytes per pixel
+inline int getDepthSize(const depthFormat& format)
+{
+	return format == depthFp ? sizeof(fp) : format == depthFloat32 ? sizeof(float) : sizeof(uint);
+}
+
+//the value a distance is multiplied by to store it in a buffer of this format
+//range: the distance stored as the highest value of a normalized format
+inline fp getDepthScale(const depthFormat& format, cfp& range)
+{
+	return format == depthUnorm24 ? (fp)(0xffffff / (double)range) : format == depthUnorm32 ? (fp)(0xffffffff / (double)range) : 1;
+}
+
+//a distance multiplied by the scale of the format, as the type the buffer stores it in
+template<typename depthType>
+inline depthType toStoredDepth(cfp& scaled)
+{
+	return (depthType)scaled;
+}
+//the highest distance can round up to 2^32 as a float, which does not fit in a uint
+template<>
+inline uint toStoredDepth<uint>(cfp& scaled)
+{
+	const double value = (double)scaled;
+	return value >= (double)0xffffffff ? 0xffffffff : value <= 0 ? 0 : (uint)value;
+}
@@ -0,0 +1,63 @@
+#include "drawcommands.h"
+
+void drawCommandBuffer::Record(const mesh* m, const mat4x4& view, const vec3& position, const vec3& lookdirection, const bool& translucent)
+{
+	drawCommand command = drawCommand();
+	command.m = m;
+	command.view = view;
+	command.position = position;
+	command.lookdirection = lookdirection;
+	command.depth = view.multPointMatrix(m->getBounds().getCenter()).z;
+	cfp relativedepth = math::minimum(math::maximum(command.depth / rendersettings::s3d::maxdistance, (fp)0), (fp)1);
+	command.layer = (int)(relativedepth * (rendersettings::s3d::drawdepthlayers - 1));
+	command.translucent = translucent;
+	commands.push_back(command);
+}
+
+void drawCommandBuffer::Sort()
+{
+	std::sort(commands.begin(), commands.end(), [](const drawCommand& a, const drawCommand& b)
+		{
+			if (a.translucent != b.translucent)
+			{
+				return b.translucent;
+			}
+			if (a.translucent)
+			{
+				//back to front
+				return a.depth > b.depth;
+			}
+			if (a.layer != b.layer)
+			{
+				return a.layer < b.layer;
+			}
+			if (a.m->tex != b.m->tex)
+			{
+				return a.m->tex < b.m->tex;
+			}
+			return a.depth < b.depth;
+		});
+}
+
+void drawCommandBuffer::Replay(const graphicsObject* graphics)
+{
+	Sort();
+	int i = 0;
+	while (i < (int)commands.size())
+	{
+		//a batch of the opaque draws in one layer, or of all translucent draws
+		const drawCommand& first = commands[i];
+		graphics->BeginTriangleBatch();
+		for (; i < (int)commands.size() && commands[i].translucent == first.translucent && (first.translucent || commands[i].layer == first.layer); i++)
+		{
+			const drawCommand& command = commands[i];
+			command.m->Draw(graphics, command.position, command.view, command.lookdirection);
+		}
+		graphics->EndTriangleBatch();
+	}
+}
+
+void drawCommandBuffer::Clear()
+{
+	commands.clear();
+}
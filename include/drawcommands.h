@@ -0,0 +1,41 @@
+#pragma once
+#include "mesh.h"
+
+namespace rendersettings
+{
+	namespace s3d
+	{
+		//the amount of depth layers the opaque draws are sorted in. inside a layer, draws are grouped by texture.
+		constexpr int drawdepthlayers = 0x10;
+	}
+}
+
+//a recorded mesh::Draw call
+struct drawCommand
+{
+	const mesh* m;
+	mat4x4 view;
+	vec3 position;
+	vec3 lookdirection;
+	//the window space depth of the center of the bounds of the mesh
+	fp depth;
+	//the depth layer of opaque draws, 0 is the closest
+	int layer;
+	bool translucent;
+};
+
+//collects draw calls, so they can be sorted before they are drawn.
+//opaque meshes are drawn front to back, grouped by texture inside every depth layer,
+//so hidden triangles fail the depth test and the hierarchical z buffer early and textures stay in the cache.
+//translucent meshes (colors with an alpha below 0xff) are drawn after them, back to front, so they blend correctly.
+struct drawCommandBuffer
+{
+	std::vector<drawCommand> commands;
+	//translucent: whether the colors of the mesh have an alpha below 0xff
+	void Record(const mesh* m, const mat4x4& view, const vec3& position, const vec3& lookdirection, const bool& translucent = false);
+	void Sort();
+	//sorts and draws the commands. the triangles of every depth layer are binned together, so the tiles are filled by all threads at once.
+	void Replay(const graphicsObject* graphics);
+	//removes the commands, but keeps the memory for the next frame
+	void Clear();
+};
@@ -0,0 +1,214 @@
+#include "edgerasterizer.h"
+
+rasterizerType rendersettings::s3d::rasterizer = rasterizeScanline;
+simdKernel rendersettings::s3d::edgekernel = getBestKernel();
+
+edgeKernelFunction getEdgeKernel(const simdKernel& kernel)
+{
+	switch (kernel)
+	{
+	case kernelAVX2:
+		return edgeKernelAVX2;
+	case kernelSSE2:
+		return edgeKernelSSE2;
+	default:
+		return edgeKernelScalar;
+	}
+}
+
+//the position in subpixels.
+//the coordinates are limited, so the edge functions fit in a long long.
+inline ll toSubpixels(cfp& value)
+{
+	constexpr fp limit = 0x1000000;
+	return (ll)floor(math::minimum(math::maximum(value, -limit), limit) * subpixelsize + 0.5);
+}
+
+//the edge from a to b
+inline edgeFunction getEdge(cll& ax, cll& ay, cll& bx, cll& by)
+{
+	edgeFunction edge = edgeFunction();
+	edge.a = ay - by;
+	edge.b = bx - ax;
+	edge.c = ax * by - ay * bx;
+	return edge;
+}
+
+//the value of the edge function at a pixel
+inline ll getEdgeValue(const edgeFunction& edge, cint& x, cint& y)
+{
+	return edge.a * ((ll)x << subpixelbits) + edge.b * ((ll)y << subpixelbits) + edge.c;
+}
+
+bool edgeSetup::setup(const fp& x0, const fp& y0, const fp& x1, const fp& y1, const fp& x2, const fp& y2, const fp& depth00, const fp& depthxstep, const fp& depthystep, const fp& mindepth)
+{
+	cll subx0 = toSubpixels(x0), suby0 = toSubpixels(y0);
+	cll subx1 = toSubpixels(x1), suby1 = toSubpixels(y1);
+	cll subx2 = toSubpixels(x2), suby2 = toSubpixels(y2);
+	edges[0] = getEdge(subx0, suby0, subx1, suby1);
+	edges[1] = getEdge(subx1, suby1, subx2, suby2);
+	edges[2] = getEdge(subx2, suby2, subx0, suby0);
+	//twice the area of the triangle in subpixels, negative when it is wound the other way
+	cll area = edges[0].a * subx2 + edges[0].b * suby2 + edges[0].c;
+	if (area == 0)
+	{
+		return false;
+	}
+	for (edgeFunction& edge : edges)
+	{
+		if (area < 0)
+		{
+			//make the inside positive
+			edge.a = -edge.a;
+			edge.b = -edge.b;
+			edge.c = -edge.c;
+		}
+		//the inside is to the right of a left edge and below a top edge.
+		//pixels exactly on other edges belong to the neighbouring triangle.
+		if (!(edge.a > 0 || (edge.a == 0 && edge.b > 0)))
+		{
+			edge.c--;
+		}
+	}
+	cint minx = (int)floor(min(min(subx0, subx1), subx2) / (fp)subpixelsize);
+	cint maxx = (int)floor(max(max(subx0, subx1), subx2) / (fp)subpixelsize);
+	cint miny = (int)floor(min(min(suby0, suby1), suby2) / (fp)subpixelsize);
+	cint maxy = (int)floor(max(max(suby0, suby1), suby2) / (fp)subpixelsize);
+	bounds = rectangle2i(minx, miny, maxx - minx + 1, maxy - miny + 1);
+	//the edge functions are linear, so they are the highest and lowest in the corners
+	fitsInt = true;
+	for (const edgeFunction& edge : edges)
+	{
+		for (cint& cornerx : { minx, maxx })
+		{
+			for (cint& cornery : { miny, maxy })
+			{
+				cll value = getEdgeValue(edge, cornerx, cornery);
+				fitsInt &= value >= INT_MIN && value <= INT_MAX;
+			}
+		}
+	}
+	this->depth00 = depth00;
+	this->depthxstep = depthxstep;
+	this->depthystep = depthystep;
+	this->mindepth = mindepth;
+	return true;
+}
+
+ull edgeKernelScalar(const edgeSetup& setup, cint& x, cint& y, cint& count, const float* depthrow, float* depths)
+{
+	ll values[3], steps[3];
+	for (int i = 0; i < 3; i++)
+	{
+		values[i] = getEdgeValue(setup.edges[i], x, y);
+		steps[i] = setup.edges[i].a << subpixelbits;
+	}
+	const float depthrowbase = (float)(setup.depth00 + setup.depthystep * y);
+	const float depthstep = (float)setup.depthxstep;
+	const float mindepth = (float)setup.mindepth;
+	ull mask = 0;
+	for (int i = 0; i < count; i++)
+	{
+		bool inside = (values[0] | values[1] | values[2]) >= 0;
+		if (inside && depthrow)
+		{
+			const float depth = max(depthrowbase + depthstep * (float)(x + i), mindepth);
+			inside = depth < depthrow[i];
+			depths[i] = depth;
+		}
+		if (inside)
+		{
+			mask |= 1ull << i;
+		}
+		values[0] += steps[0];
+		values[1] += steps[1];
+		values[2] += steps[2];
+	}
+	return mask;
+}
+
+//the edge values are added in ints. they can wrap around between pixels, but the values of the pixels in the bounds fit, so they are correct.
+ull edgeKernelSSE2(const edgeSetup& setup, cint& x, cint& y, cint& count, const float* depthrow, float* depths)
+{
+	if (!setup.fitsInt)
+	{
+		return edgeKernelScalar(setup, x, y, count, depthrow, depths);
+	}
+	const __m128 laneoffsets = _mm_setr_ps(0, 1, 2, 3);
+	__m128i values[3], steps[3];
+	for (int i = 0; i < 3; i++)
+	{
+		cint start = (int)getEdgeValue(setup.edges[i], x, y);
+		cll step = setup.edges[i].a << subpixelbits;
+		values[i] = _mm_add_epi32(_mm_set1_epi32(start), _mm_setr_epi32(0, (int)step, (int)(step * 2), (int)(step * 3)));
+		steps[i] = _mm_set1_epi32((int)(step * 4));
+	}
+	const __m128 depthrowbase = _mm_set1_ps((float)(setup.depth00 + setup.depthystep * y));
+	const __m128 depthstep = _mm_set1_ps((float)setup.depthxstep);
+	const __m128 mindepth = _mm_set1_ps((float)setup.mindepth);
+	ull mask = 0;
+	int i = 0;
+	for (; i + 4 <= count; i += 4)
+	{
+		//the sign bit is set when a pixel is outside any edge
+		__m128 outside = _mm_castsi128_ps(_mm_or_si128(_mm_or_si128(values[0], values[1]), values[2]));
+		if (depthrow)
+		{
+			const __m128 px = _mm_add_ps(_mm_set1_ps((float)(x + i)), laneoffsets);
+			const __m128 depth = _mm_max_ps(_mm_add_ps(depthrowbase, _mm_mul_ps(depthstep, px)), mindepth);
+			outside = _mm_or_ps(outside, _mm_cmpnlt_ps(depth, _mm_loadu_ps(depthrow + i)));
+			_mm_storeu_ps(depths + i, depth);
+		}
+		mask |= (ull)(~_mm_movemask_ps(outside) & 0xf) << i;
+		values[0] = _mm_add_epi32(values[0], steps[0]);
+		values[1] = _mm_add_epi32(values[1], steps[1]);
+		values[2] = _mm_add_epi32(values[2], steps[2]);
+	}
+	if (i < count)
+	{
+		mask |= edgeKernelScalar(setup, x + i, y, count - i, depthrow ? depthrow + i : nullptr, depths + i) << i;
+	}
+	return mask;
+}
+
+ull edgeKernelAVX2(const edgeSetup& setup, cint& x, cint& y, cint& count, const float* depthrow, float* depths)
+{
+	if (!setup.fitsInt)
+	{
+		return edgeKernelScalar(setup, x, y, count, depthrow, depths);
+	}
+	const __m256 laneoffsets = _mm256_setr_ps(0, 1, 2, 3, 4, 5, 6, 7);
+	__m256i values[3], steps[3];
+	for (int i = 0; i < 3; i++)
+	{
+		cint start = (int)getEdgeValue(setup.edges[i], x, y);
+		cll step = setup.edges[i].a << subpixelbits;
+		values[i] = _mm256_add_epi32(_mm256_set1_epi32(start), _mm256_setr_epi32(0, (int)step, (int)(step * 2), (int)(step * 3), (int)(step * 4), (int)(step * 5), (int)(step * 6), (int)(step * 7)));
+		steps[i] = _mm256_set1_epi32((int)(step * 8));
+	}
+	const __m256 depthrowbase = _mm256_set1_ps((float)(setup.depth00 + setup.depthystep * y));
+	const __m256 depthstep = _mm256_set1_ps((float)setup.depthxstep);
+	const __m256 mindepth = _mm256_set1_ps((float)setup.mindepth);
+	ull mask = 0;
+	int i = 0;
+	for (; i + 8 <= count; i += 8)
+	{
+		__m256 outside = _mm256_castsi256_ps(_mm256_or_si256(_mm256_or_si256(values[0], values[1]), values[2]));
+		if (depthrow)
+		{
+			const __m256 px = _mm256_add_ps(_mm256_set1_ps((float)(x + i)), laneoffsets);
+			const __m256 depth = _mm256_max_ps(_mm256_add_ps(depthrowbase, _mm256_mul_ps(depthstep, px)), mindepth);
+			outside = _mm256_or_ps(outside, _mm256_cmp_ps(depth, _mm256_loadu_ps(depthrow + i), _CMP_NLT_UQ));
+			_mm256_storeu_ps(depths + i, depth);
+		}
+		mask |= (ull)(~_mm256_movemask_ps(outside) & 0xff) << i;
+		values[0] = _mm256_add_epi32(values[0], steps[0]);
+		values[1] = _mm256_add_epi32(values[1], steps[1]);
+		values[2] = _mm256_add_epi32(values[2], steps[2]);
+	}
+	if (i < count)
+	{
+		mask |= edgeKernelSSE2(setup, x + i, y, count - i, depthrow ? depthrow + i : nullptr, depths + i) << i;
+	}
+	return mask;
+}
@@ -0,0 +1,117 @@
+#pragma once
+#include "GlobalFunctions.h"
+#include "rectangle2.h"
+#include "cpufeatures.h"
+
+//the ways triangles can be filled
+enum rasterizerType
+{
+	rasterizeScanline,//walk the rows between the edges of the triangle
+	rasterizeEdge,//test the pixels in the bounding box against the edge functions, multiple pixels at once
+};
+
+namespace rendersettings
+{
+	namespace s3d
+	{
+		extern rasterizerType rasterizer;
+		//the kernel rasterizeEdge uses. the best supported kernel by default.
+		extern simdKernel edgekernel;
+	}
+}
+
+//the most pixels an edge kernel can process at once, 1 bit per pixel in the mask it returns
+constexpr int edgeBlockSize = 0x40;
+
+//the amount of bits behind the point of the fixed point coordinates the edge functions use
+constexpr int subpixelbits = 4;
+constexpr int subpixelsize = 1 << subpixelbits;
+
+//a * x + b * y + c is >= 0 inside the triangle, with x and y in subpixels.
+//c is 1 lower for right and bottom edges, so pixels exactly on them are outside (the top-left rule).
+//the edge functions are calculated with integers, so they are exact and edges and vertices shared by triangles are never filled twice or skipped.
+struct edgeFunction
+{
+	ll a, b, c;
+};
+
+//a triangle prepared for rasterizing with edge functions
+//https://fgiesen.wordpress.com/2013/02/08/triangle-rasterization-in-practice/
+struct edgeSetup
+{
+	edgeFunction edges[3];
+	//the pixels the triangle can cover
+	rectangle2i bounds;
+	//whether the edge functions of all pixels in the bounds fit in an int, so the simd kernels can be used
+	bool fitsInt;
+	//the depth at (0, 0) and its change per pixel
+	fp depth00, depthxstep, depthystep;
+	//the lowest depth of the vertices. the pixels are tested at snapped positions, so their depths are clamped to stay inside the triangle.
+	fp mindepth;
+	//returns false if the triangle does not cover any area
+	bool setup(const fp& x0, const fp& y0, const fp& x1, const fp& y1, const fp& x2, const fp& y2, const fp& depth00, const fp& depthxstep, const fp& depthystep, const fp& mindepth);
+};
+
+//returns a bit for every pixel from x to x + count on row y that is inside the triangle.
+//depthrow: the depths of these pixels, or nullptr. when given, only the pixels closer than depthrow[i] are returned and their depths are written to depths.
+//count can not be greater than edgeBlockSize.
+typedef ull(*edgeKernelFunction)(const edgeSetup& setup, cint& x, cint& y, cint& count, const float* depthrow, float* depths);
+
+edgeKernelFunction getEdgeKernel(const simdKernel& kernel);
+
+ull edgeKernelScalar(const edgeSetup& setup, cint& x, cint& y, cint& count, const float* depthrow, float* depths);
+ull edgeKernelSSE2(const edgeSetup& setup, cint& x, cint& y, cint& count, const float* depthrow, float* depths);
+ull edgeKernelAVX2(const edgeSetup& setup, cint& x, cint& y, cint& count, const float* depthrow, float* depths);
+
+//the kernels can only test float depth buffers themselves
+inline const float* getKernelDepthRow(const float* depthrow)
+{
+	return depthrow;
+}
+template<typename depthType>
+inline const float* getKernelDepthRow(const depthType* depthrow)
+{
+	return nullptr;
+}
+
+//calls shadeBlock(y, x, mask, depths) for every part of a row of the triangle inside the clip rectangle.
+//mask: a bit for every pixel from x that is covered and, for float depth buffers, closer than the depth buffer. depths: the depths of these pixels.
+//every pixel is tested on its own coordinates, so the result does not depend on the clip rectangle.
+template<typename depthType, typename shadeFunction>
+inline void forEachTriangleBlock(const edgeSetup& setup, crectangle2i& clip, const depthType* depthbuffer, cint& width, shadeFunction shadeBlock)
+{
+	const edgeKernelFunction kernel = getEdgeKernel(rendersettings::s3d::edgekernel);
+	cint minx = max(setup.bounds.x, clip.x), maxx = min(setup.bounds.x + setup.bounds.w, clip.x + clip.w);
+	cint miny = max(setup.bounds.y, clip.y), maxy = min(setup.bounds.y + setup.bounds.h, clip.y + clip.h);
+	float depths[edgeBlockSize];
+	for (int y = miny; y < maxy; y++)
+	{
+		for (int x = minx; x < maxx; x += edgeBlockSize)
+		{
+			cint count = min(edgeBlockSize, maxx - x);
+			const ull mask = kernel(setup, x, y, count, getKernelDepthRow(depthbuffer + x + y * width), depths);
+			if (mask)
+			{
+				shadeBlock(y, x, mask, depths);
+			}
+		}
+	}
+}
+
+//returns the index of the lowest bit that is set and removes it from the mask
+inline int popLowestBit(ull& mask)
+{
+	unsigned long index;
+#ifdef _WIN64
+	_BitScanForward64(&index, mask);
+#else
+	//32 bit builds only have the 32 bit scan
+	if (!_BitScanForward(&index, (unsigned long)mask))
+	{
+		_BitScanForward(&index, (unsigned long)(mask >> 32));
+		index += 32;
+	}
+#endif
+	mask &= mask - 1;
+	return (int)index;
+}
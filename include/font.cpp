@@ -2,29 +2,70 @@
 
 void font::DrawString(const std::wstring text, crectangle2& rect, const graphicsObject& obj) const
 {
-	if (text.length()) {
-		const letter* textptr = text.c_str();
-		const letter* textendptr = textptr + text.length();
-		cvec2 topleft = vec2(rect.x, rect.y + rect.h - fontSize);
-		vec2 off = topleft;//top left
-		//color* colorptr = tex->colors;
-		//combine both brushes
-		while (textptr < textendptr)
+	textLayout layout = textLayout();
+	layout.Layout(*this, text, rect.size);
+	layout.Draw(*this, rect.pos00, obj);
+}
+
+bool textLayout::isValid(const font& f, const std::wstring& text, cvec2& size) const
+{
+	if (family != f.family || fontSize != f.fontSize || this->size.x != size.x || this->size.y != size.y)
+	{
+		return false;
+	}
+	//the part below the rectangle does not matter
+	return truncated ? text.compare(0, this->text.length(), this->text) == 0 : text == this->text;
+}
+
+void textLayout::Layout(const font& f, const std::wstring& text, cvec2& size)
+{
+	family = f.family;
+	fontSize = f.fontSize;
+	this->size = size;
+	letters.clear();
+	cvec2 topleft = vec2(0, size.y - fontSize);
+	vec2 off = topleft;
+	size_t index = 0;
+	for (; index < text.length(); index++)
+	{
+		if (off.y + fontSize <= 0)
 		{
-			if (*textptr == L'\n') 
-			{
-				off.x = topleft.x;
-				off.y -= fontSize;
-			}
-			else 
+			//this line and the next lines are below the rectangle
+			break;
+		}
+		cletter l = text[index];
+		if (l == L'\n')
+		{
+			off.x = topleft.x;
+			off.y -= fontSize;
+		}
+		else
+		{
+			if (off.x < size.x)
 			{
-				byte b = (byte)*textptr;
-				cint ix = b % 0x10;//the x index of the letter image
-				cint iy = b / 0x10;//the y index of the letter image
-				family->DrawLetter(*textptr, vec2(off.x, off.y), fontSize, obj, fontBrush);
-				off.x += MeasureLetterWidth(*textptr);
+				placedLetter placed = placedLetter();
+				placed.l = l;
+				placed.offset = off;
+				letters.push_back(placed);
 			}
-			textptr++;
+			off.x += f.MeasureLetterWidth(l);
 		}
 	}
+	truncated = index < text.length();
+	this->text = text.substr(0, index);
+}
+
+void textLayout::Draw(const font& f, cvec2& position, const graphicsObject& obj) const
+{
+	rectangle2i clip = floorRect(rectangle2(position, size));
+	clip.crop(obj.getDrawRect());
+	if (clip.w <= 0 || clip.h <= 0)
+	{
+		return;
+	}
+	for (const placedLetter& placed : letters)
+	{
+		cvec2 pos = position + placed.offset;
+		f.family->DrawGlyph(f.family->getGlyph(placed.l, fontSize), vec2i((int)pos.x, (int)pos.y), clip, obj);
+	}
 }
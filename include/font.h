@@ -1,4 +1,35 @@
 #include "fontfamily.h"
+struct font;
+
+//a letter of a layout, at an offset from the position of the layout
+struct placedLetter
+{
+	letter l;
+	vec2 offset;
+};
+
+//the positions of the letters of a text in a rectangle.
+//lines below the rectangle and letters right of it are not laid out.
+struct textLayout
+{
+	//what the layout was made with
+	const fontFamily* family = nullptr;
+	fp fontSize = 0;
+	vec2 size = vec2();
+	//the part of the text that was laid out
+	std::wstring text = L"";
+	//the text continued below the rectangle
+	bool truncated = false;
+
+	std::vector<placedLetter> letters;
+
+	//if laying out the text with the font in a rectangle of this size would give the same letters
+	bool isValid(const font& f, const std::wstring& text, cvec2& size) const;
+	void Layout(const font& f, const std::wstring& text, cvec2& size);
+	//draws the letters, clipped to the rectangle at position
+	void Draw(const font& f, cvec2& position, const graphicsObject& obj) const;
+};
+
 struct font 
 {
 	fontFamily* family = nullptr;
@@ -1,20 +1,6 @@
 #include "fontfamily.h"
 #include "graphics.h"
 
-struct letterDrawer : public linkedBrush
-{
-	const fontFamily* f = nullptr;
-	rectangle2 letterRect = vec2();
-	rectangle2 maskBrushRect = vec2();
-	virtual color getColor(cvec2& pos) const override;
-};
-
-color letterDrawer::getColor(cvec2& pos) const
-{
-	color c = f->tex->getColor((pos - letterRect.pos00) / letterRect.size * maskBrushRect.size + maskBrushRect.pos00);
-	return colorMixer::getColor(c, g->getColor(pos));
-}
-
 //the texture has to have a transparent background with black letters.
 //Be careful: the actual texture will be modified!
 fontFamily::fontFamily(Texture* texture, const bool flipRows)
@@ -40,21 +26,74 @@ fontFamily::fontFamily(Texture* texture, const bool flipRows)
 	}
 }
 
-void fontFamily::DrawLetter(cletter& l, cvec2& position, cfp& letterSize, const graphicsObject& obj, const brush* b) const
+const glyph& fontFamily::getGlyph(cletter& l, cfp& letterSize) const
 {
+	cint size = max((int)letterSize, 0);
+	std::list<glyph>& sizes = glyphs[(byte)l];
+	for (const glyph& g : sizes)
+	{
+		if (g.size == size)
+		{
+			return g;
+		}
+	}
 	byte letterIndex = (byte)l;
 	cvec2i asciiOffset = cvec2i(letterIndex % asciiRowWidth,//the x index of the letter image
 		letterIndex / asciiRowWidth);//the y index of the letter image
 
 	cvec2i texLetterSize = cvec2i(tex->width / asciiRowWidth);
 	cvec2 texOffset = asciiOffset * texLetterSize;
+	glyph g = glyph();
+	g.size = size;
+	cvec2 scale = vec2(texLetterSize) / (fp)max(size, 1);
+	g.colors = std::vector<color>(g.size * g.size);
+	g.rowstart = std::vector<int>(g.size, g.size);
+	g.rowend = std::vector<int>(g.size, 0);
+	for (int j = 0; j < g.size; j++)
+	{
+		for (int i = 0; i < g.size; i++)
+		{
+			const color c = tex->getColor(vec2(i, j) * scale + texOffset);
+			g.colors[i + j * g.size] = c;
+			if (c.a > 0)
+			{
+				g.rowstart[j] = min(g.rowstart[j], i);
+				g.rowend[j] = i + 1;
+			}
+		}
+	}
+	sizes.push_back(g);
+	return sizes.back();
+}
 
-	letterDrawer* drawer = new letterDrawer();
-	drawer->maskBrushRect = rectangle2( texOffset,vec2(texLetterSize));
-	drawer->letterRect = rectangle2(position, vec2(letterSize));
-	drawer->f = this;
-	drawer->g = &obj;
-	obj.fillRectangleUnsafe(crectangle2i(position.x, position.y, letterSize, letterSize), drawer);
+void fontFamily::ClearGlyphs() const
+{
+	for (std::list<glyph>& sizes : glyphs)
+	{
+		sizes.clear();
+	}
+}
 
+//the brush is not used, the letters have the colors of tex
+void fontFamily::DrawLetter(cletter& l, cvec2& position, cfp& letterSize, const graphicsObject& obj, const brush* b) const
+{
+	DrawGlyph(getGlyph(l, letterSize), vec2i((int)position.x, (int)position.y), obj.getDrawRect(), obj);
 }
 
+void fontFamily::DrawGlyph(const glyph& g, cvec2i& position, crectangle2i& clip, const graphicsObject& obj) const
+{
+	cint minx = max(position.x, clip.x), maxx = min(position.x + g.size, clip.x + clip.w);
+	cint miny = max(position.y, clip.y), maxy = min(position.y + g.size, clip.y + clip.h);
+	const compositeFunction kernel = getCompositeKernel(rendersettings::checkopacity ? blendSourceOver : blendCopy, rendersettings::compositekernel);
+	for (int y = miny; y < maxy; y++)
+	{
+		cint j = y - position.y;
+		//without opacity checks, the transparent pixels are copied too
+		cint start = rendersettings::checkopacity ? max(position.x + g.rowstart[j], minx) : minx;
+		cint end = rendersettings::checkopacity ? min(position.x + g.rowend[j], maxx) : maxx;
+		if (start < end)
+		{
+			kernel(obj.colors + start + y * obj.width, &g.colors[(start - position.x) + j * g.size], end - start);
+		}
+	}
+}
@@ -8,14 +8,32 @@ cint asciiColumnHeight = 0x10;
 //the amount of letters in an ascii charachter set
 cint asciiLetterCount = 0x100;
 
+//a letter of tex, rasterized at a size in pixels
+struct glyph
+{
+	int size = 0;
+	//size * size colors, in the same order as the rows of the screen
+	std::vector<color> colors;
+	//the first pixel and the last pixel + 1 of every row that are not transparent
+	std::vector<int> rowstart, rowend;
+};
+
 class fontFamily
 {
 public:
 	fontFamily(Texture* texture, const bool flipRows = true);
 	void DrawLetter(cletter& l, cvec2& position, cfp& letterSize, const graphicsObject& obj, const brush* b) const;
+	//the letter rasterized at the size, rounded down to pixels. it is rasterized the first time it is asked for.
+	//the glyph stays at the same address until ClearGlyphs is called.
+	const glyph& getGlyph(cletter& l, cfp& letterSize) const;
+	//draws the part of the glyph inside clip, with its first pixel at position. clip has to be inside the screen.
+	void DrawGlyph(const glyph& g, cvec2i& position, crectangle2i& clip, const graphicsObject& obj) const;
+	//forgets the rasterized letters. call this after changing tex.
+	void ClearGlyphs() const;
 	Texture* tex;
 	
 private:
-
+	//the rasterized letters of each ascii letter, one per pixel size. a list does not move its elements when adding one.
+	mutable std::list<glyph> glyphs[asciiLetterCount];
 };
 
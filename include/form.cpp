@@ -1,4 +1,84 @@
 #include "form.h"
 form::form(crectangle2i& rect):Control(rect)
 {
-}
\ No newline at end of file
+	//nothing has been drawn yet
+	Invalidate();
+}
+
+inline int getArea(crectangle2i& rect)
+{
+	return rect.w * rect.h;
+}
+
+void form::Invalidate(crectangle2i& region)
+{
+	//a form has no parent, this only invalidates its cache
+	Control::Invalidate(region);
+	rectangle2i merged = region;
+	merged.crop(rectangle2i(rect.size));
+	if (merged.w <= 0 || merged.h <= 0)
+	{
+		return;
+	}
+	//merge the regions it overlaps with, until it overlaps none of them
+	for (size_t i = 0; i < dirtyRects.size();)
+	{
+		if (merged.intersects(dirtyRects[i]))
+		{
+			merged = merged.united(dirtyRects[i]);
+			dirtyRects.erase(dirtyRects.begin() + i);
+			i = 0;
+		}
+		else
+		{
+			i++;
+		}
+	}
+	dirtyRects.push_back(merged);
+	if (dirtyRects.size() > maxdirtyrects)
+	{
+		//merge the 2 regions whose bounds add the least area that was not dirty
+		size_t besti = 0, bestj = 1;
+		int leastwaste = INT_MAX;
+		for (size_t i = 0; i < dirtyRects.size(); i++)
+		{
+			for (size_t j = i + 1; j < dirtyRects.size(); j++)
+			{
+				cint waste = getArea(dirtyRects[i].united(dirtyRects[j])) - getArea(dirtyRects[i]) - getArea(dirtyRects[j]);
+				if (waste < leastwaste)
+				{
+					leastwaste = waste;
+					besti = i;
+					bestj = j;
+				}
+			}
+		}
+		crectangle2i bounds = dirtyRects[besti].united(dirtyRects[bestj]);
+		dirtyRects.erase(dirtyRects.begin() + bestj);
+		dirtyRects.erase(dirtyRects.begin() + besti);
+		//the bounds can overlap other regions
+		Invalidate(bounds);
+	}
+}
+
+std::vector<rectangle2i> form::DrawDirty(const graphicsObject& obj, const color& background)
+{
+	if (redrawEveryFrame)
+	{
+		Invalidate();
+	}
+	//controls can mark themselves while drawing, for the next frame
+	std::vector<rectangle2i> drawn = std::vector<rectangle2i>();
+	std::swap(drawn, dirtyRects);
+	for (crectangle2i& region : drawn)
+	{
+		obj.SetClip(region);
+		obj.fillRectangle(region, background);
+		if (visible)
+		{
+			Render(cvec2i(0, 0), obj);
+		}
+	}
+	obj.ResetClip();
+	return drawn;
+}
@@ -1,8 +1,20 @@
 #include "Control.h"
 
 #pragma once
+//the most regions the form keeps apart. more regions are merged into the ones they fit best with.
+constexpr int maxdirtyrects = 8;
+
 struct form :public Control 
 {
 	form(crectangle2i& rect);
-	
-};
\ No newline at end of file
+	//draw the whole form every frame, for forms with controls that change without calling Invalidate, like 3d views.
+	//turn it off to only draw the parts that were invalidated and let the application sleep when nothing changed.
+	bool redrawEveryFrame = true;
+	//the parts of the form that have to be drawn again, not overlapping eachother
+	std::vector<rectangle2i> dirtyRects;
+	using Control::Invalidate;
+	virtual void Invalidate(crectangle2i& region) override;
+	//clears the dirty parts to background and draws the controls in them again. everything is dirty when redrawEveryFrame is on.
+	//returns the parts that were drawn, which are the only parts of the screen that changed.
+	std::vector<rectangle2i> DrawDirty(const graphicsObject& obj, const color& background);
+};
@@ -0,0 +1,64 @@
+#include "framearena.h"
+#include <malloc.h>
+
+frameArena::frameArena(const size_t& blocksize) :blocksize(blocksize)
+{
+}
+
+frameArena::~frameArena()
+{
+	for (const arenaBlock& block : blocks)
+	{
+		_aligned_free(block.memory);
+	}
+}
+
+void* frameArena::allocate(const size_t& size)
+{
+	const size_t alignedsize = (size + arenaAlignment - 1) & ~(arenaAlignment - 1);
+	if (blocks.empty() || offset + alignedsize > blocks.back().size)
+	{
+		const size_t newsize = max(blocksize, alignedsize);
+		blocks.push_back(arenaBlock{ (byte*)_aligned_malloc(newsize, arenaAlignment), newsize });
+		offset = 0;
+	}
+	void* const ptr = blocks.back().memory + offset;
+	offset += alignedsize;
+	used += alignedsize;
+	highwatermark = max(highwatermark, used);
+	framehighwatermark = max(framehighwatermark, used);
+	return ptr;
+}
+
+void frameArena::reset()
+{
+	if (blocks.size() > 1)
+	{
+		const size_t capacity = getCapacity();
+		for (const arenaBlock& block : blocks)
+		{
+			_aligned_free(block.memory);
+		}
+		blocks.clear();
+		blocks.push_back(arenaBlock{ (byte*)_aligned_malloc(capacity, arenaAlignment), capacity });
+	}
+	offset = 0;
+	used = 0;
+}
+
+size_t frameArena::endFrame()
+{
+	const size_t peak = framehighwatermark;
+	framehighwatermark = 0;
+	return peak;
+}
+
+size_t frameArena::getCapacity() const
+{
+	size_t capacity = 0;
+	for (const arenaBlock& block : blocks)
+	{
+		capacity += block.size;
+	}
+	return capacity;
+}
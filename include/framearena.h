@@ -0,0 +1,49 @@
+#pragma once
+#include "GlobalFunctions.h"
+
+//the alignment of every allocation from a frame arena, enough for sse and for all vector types
+constexpr size_t arenaAlignment = 0x10;
+
+//a linear allocator for buffers that are only needed during one draw call.
+//allocating only moves an offset forward, and nothing is freed until reset is called.
+//memory from the arena is not initialized and no destructors are called, so only use it for plain data.
+//not thread safe, allocate from the thread that draws.
+struct frameArena
+{
+	//the memory is never moved, so a new block is added when the last one is full.
+	//the blocks are allocated aligned to arenaAlignment.
+	struct arenaBlock
+	{
+		byte* memory;
+		size_t size;
+	};
+	std::vector<arenaBlock> blocks;
+	//the used bytes of the last block
+	size_t offset = 0;
+	//the bytes allocated since the last reset
+	size_t used = 0;
+	//the most bytes that were allocated between two resets, to size the arena with
+	size_t highwatermark = 0;
+	//the same as highwatermark, but only since the last call to endFrame
+	size_t framehighwatermark = 0;
+	//the smallest size of a new block
+	size_t blocksize;
+
+	frameArena(const size_t& blocksize = 0x100000);
+	frameArena(const frameArena&) = delete;
+	frameArena& operator=(const frameArena&) = delete;
+	~frameArena();
+	void* allocate(const size_t& size);
+	template<typename t>
+	inline t* allocate(cint& count)
+	{
+		return (t*)allocate(count * sizeof(t));
+	}
+	//releases everything allocated since the last reset.
+	//when more than one block was needed, they are replaced by one block big enough for all of them.
+	void reset();
+	//returns the most bytes that were allocated between two resets since the last call, so the arena can be sized per frame.
+	size_t endFrame();
+	//the bytes in all blocks
+	size_t getCapacity() const;
+};
@@ -2,8 +2,7 @@
 #include <array>
 #include "mat4x4.h"
 #include "vec3.h"
-
-struct AABB;
+#include "aabb.h"
 
 struct Plane
 {
@@ -19,6 +18,10 @@ public:
 	void update(const mat4x4& projViewMatrix) noexcept;
 
 	bool isBoxInFrustum(const vec3 position, const vec3 size) const noexcept;
+	inline bool isBoxInFrustum(const AABB& box) const noexcept
+	{
+		return isBoxInFrustum(box.pos00, box.size);
+	}
 
 private:
 	std::array<Plane, 6> m_planes;
@@ -1,4 +1,5 @@
 #include "graphics.h"
+#include "postprocess.h"
 
 //ideas:
 //https://web.stanford.edu/class/archive/cs/cs106b/cs106b.1126/materials/cppdoc/graphics.html
@@ -10,6 +11,7 @@ bool rendersettings::s3d::backfaceculling::enabled = true;
 bool rendersettings::s3d::backfaceculling::clockwise = false;
 fp rendersettings::s3d::mindistance = 0.1;
 fp rendersettings::s3d::maxdistance = 0x100;
+bool rendersettings::s3d::mipmapping = true;
 
 //set the screen to the background color
 void graphicsObject::ClearColor(const color BackGroundColor) const
@@ -30,12 +32,19 @@ void graphicsObject::fill(const color c) const
 {
 	if (c.a == 0xff || !rendersettings::checkopacity) 
 	{
-		ClearColor(c);
+		if (clipping)
+		{
+			fillRectangleUnsafe(getDrawRect(), c);
+		}
+		else
+		{
+			ClearColor(c);
+		}
 	}
 	else
 	{
 		if (c.a == 0)return;
-		fillRectangleUnsafe(getClientRect(), c);
+		fillRectangleUnsafe(getDrawRect(), c);
 	}
 }
 
@@ -68,22 +77,31 @@ void graphicsObject::fillCircle(fp x, fp y, fp w, fp h, const brush& b) const
 	fp midy = y + h * .5;
 	fp multx = 1 / (midx - x);//multipliers
 	fp multy = 1 / (midy - y);
-	color* ptr = colors + MinX + MinY * this->width;
 	for (int j = MinY; j < MaxY; j++)
 	{
-		color* NextPtr = ptr + this->width;
 		fp dy = (j - midy) * multy;
 		fp dy2 = dy * dy;
-		for (int i = MinX; i < MaxX; i++)
+		if (!(dy2 < 1))
+		{
+			continue;
+		}
+		const auto inside = [&](cint& i)
 		{
 			fp dx = (i - midx) * multx;
-			if (dy2 + dx * dx < 1)
-			{
-				*ptr = b.getColor(vec2(i, j));
-			}
-			ptr++;
+			return dy2 + dx * dx < 1;
+		};
+		//the row of the ellipse is one span. its ends are tested like the pixels were before, so rounding does not change which pixels are filled.
+		cfp halfwidth = sqrt(1 - dy2) / multx;
+		int spanminx = math::maximum((int)ceil(midx - halfwidth), MinX);
+		int spanmaxx = math::minimum((int)floor(midx + halfwidth) + 1, MaxX);
+		while (spanminx > MinX && inside(spanminx - 1)) spanminx--;
+		while (spanminx < spanmaxx && !inside(spanminx)) spanminx++;
+		while (spanmaxx < MaxX && inside(spanmaxx)) spanmaxx++;
+		while (spanmaxx > spanminx && !inside(spanmaxx - 1)) spanmaxx--;
+		if (spanminx < spanmaxx)
+		{
+			b.fillSpan(j, spanminx, spanmaxx, colors + spanminx + j * this->width);
 		}
-		ptr = NextPtr;
 	}
 }
 void graphicsObject::fillCircleCentered(cvec2& pos, cvec2& size, const brush& b) const
@@ -275,22 +293,16 @@ void graphicsObject::visualizeFormula(const rectangle2& screenRect, const rectan
 }
 void graphicsObject::Fade(const fp& weight, const color& fadeto) const
 {
-	cint size = width * height;
-	color* const end = colors + size;
-	for (color* c = colors; c < end; c++)
-	{
-		*c = color::lerpcolor(fadeto, *c, weight);
-	}
+	postProcess pass;
+	pass.AddFade(weight, fadeto);
+	pass.Apply(*this);
 }
 //fade to transparency
 void graphicsObject::Fade(fp multiplier) const
 {
-	int size = width * height;
-	color* end = colors + size;
-	for (color* c = colors; c < end; c++) 
-	{
-		*c = *c * multiplier;
-	}
+	postProcess pass;
+	pass.AddMultiply(multiplier);
+	pass.Apply(*this);
 }
 
 color graphicsObject::GetPixel(cvec2i& pos) const
@@ -319,7 +331,16 @@ fp graphicsObject::GetDepth(cint& x, cint& y) const
 }
 fp graphicsObject::GetDepthUnsafe(cint& x, cint& y) const
 {
-	return depthbuffer[x + y * width];
+	cint index = x + y * width;
+	switch (depthformat)
+	{
+	case depthFp:
+		return ((fp*)depthbuffer)[index];
+	case depthFloat32:
+		return ((float*)depthbuffer)[index];
+	default:
+		return ((uint*)depthbuffer)[index] / getDepthScale(depthformat, depthrange);
+	}
 }
 bool graphicsObject::InBounds(cint x, cint y) const
 {
@@ -328,22 +349,27 @@ bool graphicsObject::InBounds(cint x, cint y) const
 //fill the depthbuffer with the maximum distance where triangles are allowed to be drawn.
 //this will be the maximum distance in 'rendersettings' by default.
 //https://en.wikipedia.org/wiki/Z-buffering
+//the normalized formats store MaxDistance as their highest value.
 void graphicsObject::ClearDepthBuffer(cfp MaxDistance) const
 {
-	std::fill(depthbuffer, depthbuffer + this->width * this->height, MaxDistance);
+	depthrange = MaxDistance;
+	if (hiz)
+	{
+		hiz->reset(MaxDistance);
+	}
+	dispatchDepthBuffer([this, MaxDistance](auto* const depthptr, cfp& scale)
+		{
+			typedef std::remove_pointer_t<decltype(depthptr)> depthType;
+			std::fill(depthptr, depthptr + this->width * this->height, toStoredDepth<depthType>(MaxDistance * scale));
+		});
 }
 
 
 void graphicsObject::Fog(color FogColor, cfp& multiplier) const
 {
-	color* ptr = colors;
-	color* endptr = colors + this->width * this->height;
-	fp* DepthPtr = depthbuffer;
-	while (ptr < endptr)
-	{
-		*ptr++ = color::lerpcolor(*ptr, FogColor, *DepthPtr * multiplier);
-		DepthPtr++;
-	}
+	postProcess pass;
+	pass.AddFog(FogColor, multiplier);
+	pass.Apply(*this);
 }
 //switch points so y0 <= y1 <= y2
 inline void switchy(int (&switchindexes)[3], const fp (&screeny)[3])
@@ -407,353 +433,271 @@ bool windedcorrect(const vec2 a, const vec2 b, const vec2 c)
 	const fp winding = dab.x * dac.y - dab.y * dac.x;
 	return rendersettings::s3d::backfaceculling::clockwise ? winding < 0: winding > 0;
 }
-//with textures
-//void graphicsObject::DrawTrianglesTex(fp* vertices, uint* indices, const uint& TriangleCount, const uint& VerticeCount, const vec3& position, mat4x4& view,const Texture& tex, const vec3& lookdirection) const
-//vertices:
-//stepcount:the amount of vectors
-//stride:the stride of a vector
-//
-void graphicsObject::DrawTrianglesTex(const bufferobject<fp>* vertices, const bufferobject<fp>* texturecoords, const bufferobject<uint>* indices, const vec3& position, const mat4x4& view, const Texture& tex, const vec3& lookdirection) const
+//projects the vertices once for every view matrix and submits every visible part of every triangle of every instance.
+//setAttributes(instance, triangleindex, vertexindices, tri, screentri) sets the texture coordinates and light of tri
+//and the texture or color of screentri.
+//triangles are discarded as early as possible:
+//first when all vertices are outside the same frustum plane, then by their winding, using only the indices and projected vertices.
+//only triangles crossing the near plane or the guard band are clipped.
+template<triangleShading shading, typename attributeFunction>
+void graphicsObject::DrawTrianglesShaded(const bufferobject<fp>* vertices, const bufferobject<uint>* indices, const mat4x4* views, cint& instancecount, attributeFunction setAttributes) const
 {
-	vec3* const vertices2D = new vec3[vertices->stepcount];
-	//cint Stride = 3;//no need for texture indicing or light leveling
+	constexpr bool textured = shading == shadingTexture || shading == shadingTextureLight;
+	constexpr bool lit = shading == shadingTextureLight || shading == shadingPlainLight;
+	cint vertexcount = vertices->stepcount;
+	if (vertexcount == 0 || instancecount == 0)
+	{
+		return;
+	}
+	frameArena* const arena = getFrameArena();
+	vec3* const vertices2D = arena->allocate<vec3>(vertexcount * instancecount);
+	fp* const vertexw = arena->allocate<fp>(vertexcount * instancecount);
 	// vertices to 2D
-	vec3* p2d = vertices2D;
-	const fp* p3d = vertices->buffer;
-	const fp* end = p3d + vertices->stride * vertices->stepcount;
-	while (p3d < end)
+	transformVerticesInstanced(views, instancecount, vertices, width, height, vertices2D, vertexw);
+	byte* const outcodes = arena->allocate<byte>(vertexcount * instancecount);
+	for (int i = 0; i < vertexcount * instancecount; i++)
 	{
-		*p2d++ = windowspace(view, *(vec3*)p3d);// - position);
-		p3d += vertices->stride;
+		outcodes[i] = (byte)getOutcode(vertices2D[i], vertexw[i], width, height, rendersettings::s3d::maxdistance);
 	}
-	const uint* indPtr = indices->buffer;
-	for (
-		int i = 0;
-		i < indices->stepcount;
-		i++, indPtr += indices->stride
-		)//iterate for each tri
+	for (int instance = 0; instance < instancecount; instance++)
 	{
-		// Get Values
-		cint //get indices(they will be used multiple times)
-			indicevert0 = *indPtr,
-			indicevert1 = *(indPtr + 1),
-			indicevert2 = *(indPtr + 2);
-		triangle tris[2];//max count of clipped triangles is 2
-		//set first triangle
-		tris[0].p[0] = *(vec3*)(vertices->buffer + indicevert0 * vertices->stride);
-		tris[0].p[1] = *(vec3*)(vertices->buffer + indicevert1 * vertices->stride);
-		tris[0].p[2] = *(vec3*)(vertices->buffer + indicevert2 * vertices->stride);
-		tris[0].t[0] = *(vec2*)(texturecoords->buffer + indicevert0 * texturecoords->stride);
-		tris[0].t[1] = *(vec2*)(texturecoords->buffer + indicevert1 * texturecoords->stride);
-		tris[0].t[2] = *(vec2*)(texturecoords->buffer + indicevert2 * texturecoords->stride);
-		tris[0].screen[0] = *(vertices2D + indicevert0);
-		tris[0].screen[1] = *(vertices2D + indicevert1);
-		tris[0].screen[2] = *(vertices2D + indicevert2);
-		triangle t = tris[0];//copy
-		int ClippedTriangleCount = Triangle_ClipAgainstScreen(view, t, tris[0], tris[1]);
-
-		//clippedtrianglecount can be zero, it will just skip this section.
-		for (int ClippedTriangleIndex = 0; ClippedTriangleIndex < ClippedTriangleCount; ClippedTriangleIndex++)
+		const mat4x4& view = views[instance];
+		const vec3* const instancevertices2D = vertices2D + instance * vertexcount;
+		const byte* const instanceoutcodes = outcodes + instance * vertexcount;
+		//the whole instance is outside a plane of the frustum
+		int instanceoutcode = instanceoutcodes[0];
+		for (int i = 1; i < vertexcount && instanceoutcode; i++)
 		{
-			const triangle* activetri = (&tris[ClippedTriangleIndex]);
-			const fp screenx[3] = { activetri->screen[0].x, activetri->screen[1].x, activetri->screen[2].x };//screen coordinates
-			const fp screeny[3] = { activetri->screen[0].y, activetri->screen[1].y, activetri->screen[2].y };
-			const fp distance[3] = { activetri->screen[0].z, activetri->screen[1].z, activetri->screen[2].z };
-			// Calculate triangle screen bounds
-			fp minx, maxx;
-			if (screenx[0] < screenx[1])
+			instanceoutcode &= instanceoutcodes[i];
+		}
+		if (instanceoutcode)
+		{
+			continue;
+		}
+		//the whole instance is behind what was drawn already
+		if (rendersettings::s3d::occlusionculling && isOccluded(instancevertices2D, vertexcount))
+		{
+			continue;
+		}
+		const uint* indPtr = indices->buffer;
+		for (
+			int i = 0;
+			i < indices->stepcount;
+			i++, indPtr += indices->stride
+			)//iterate for each tri
+		{
+			// Get Values
+			cint vertexindices[3] = { (int)*indPtr, (int)*(indPtr + 1), (int)*(indPtr + 2) };
+			cint outcode0 = instanceoutcodes[vertexindices[0]], outcode1 = instanceoutcodes[vertexindices[1]], outcode2 = instanceoutcodes[vertexindices[2]];
+			//all vertices are outside the same plane
+			if (outcode0 & outcode1 & outcode2)
 			{
-				minx = min(screenx[0], screenx[2]);
-				maxx = max(screenx[1], screenx[2]);
+				continue;
 			}
-			else
+			const bool clipnear = ((outcode0 | outcode1 | outcode2) & outsideNear) != 0;
+			//https://stackoverflow.com/questions/9120032/determine-winding-of-a-2d-triangles-after-triangulation
+			//vertices behind the camera are not projected, so those triangles are tested after clipping
+			if (!clipnear && rendersettings::s3d::backfaceculling::enabled &&
+				!windedcorrect(instancevertices2D[vertexindices[0]].Get2d(), instancevertices2D[vertexindices[1]].Get2d(), instancevertices2D[vertexindices[2]].Get2d()))
 			{
-				minx = min(screenx[1], screenx[2]);
-				maxx = max(screenx[0], screenx[2]);
+				continue;
 			}
-			//if the triangle is less than a pixel broad or out of reach then dont draw it.
-			if ((int)minx == (int)maxx || minx > this->width || maxx < 0) continue;
-			//https://stackoverflow.com/questions/9120032/determine-winding-of-a-2d-triangles-after-triangulation
-			if (rendersettings::s3d::backfaceculling::enabled)
+			binnedTriangle screentri;
+			screentri.shading = shading;
+			triangle tris[2 * maxGuardBandTriangles];//max count of clipped triangles is 2 at the near plane, 5 for each of them at the guard band
+			for (int pointIndex = 0; pointIndex < 3; pointIndex++)
+			{
+				tris[0].screen[pointIndex] = instancevertices2D[vertexindices[pointIndex]];
+				tris[0].w[pointIndex] = vertexw[instance * vertexcount + vertexindices[pointIndex]];
+			}
+			setAttributes(instance, i, vertexindices, tris[0], screentri);
+			int ClippedTriangleCount = 1;
+			if (clipnear)
 			{
-				if (!windedcorrect(activetri->screen[0].Get2d(), activetri->screen[1].Get2d(), activetri->screen[2].Get2d()))
+				for (int pointIndex = 0; pointIndex < 3; pointIndex++)
 				{
-					continue;
+					tris[0].p[pointIndex] = *(vec3*)(vertices->buffer + vertexindices[pointIndex] * vertices->stride);
 				}
+				triangle t = tris[0];//copy
+				ClippedTriangleCount = Triangle_ClipAgainstScreen(view, t, tris[0], tris[1]);
 			}
-			int switchind[3];
-			switchy(switchind, screeny);
-			//if the triangle is less than a pixel heigh or is out of reach then dont fill it.
-			if ((int)screeny[switchind[0]] == (int)screeny[switchind[2]] || screeny[switchind[0]] > this->height || screeny[switchind[2]] < 0) continue;
+			//the triangles split at the near plane reach the furthest off screen, so every triangle is checked
+			triangle nearclipped[2];
+			cint nearcount = ClippedTriangleCount;
+			std::copy(tris, tris + nearcount, nearclipped);
+			ClippedTriangleCount = 0;
+			for (int nearindex = 0; nearindex < nearcount; nearindex++)
+			{
+				if (isOutsideGuardBand(nearclipped[nearindex], width, height))
+				{
+					ClippedTriangleCount += clipToGuardBand(nearclipped[nearindex], width, height, tris + ClippedTriangleCount);
+				}
+				else
+				{
+					tris[ClippedTriangleCount++] = nearclipped[nearindex];
+				}
+			}
+
+			//clippedtrianglecount can be zero, it will just skip this section.
+			for (int ClippedTriangleIndex = 0; ClippedTriangleIndex < ClippedTriangleCount; ClippedTriangleIndex++)
+			{
+				const triangle* activetri = (&tris[ClippedTriangleIndex]);
+				const fp screenx[3] = { activetri->screen[0].x, activetri->screen[1].x, activetri->screen[2].x };//screen coordinates
+				const fp screeny[3] = { activetri->screen[0].y, activetri->screen[1].y, activetri->screen[2].y };
+				const fp distance[3] = { activetri->screen[0].z, activetri->screen[1].z, activetri->screen[2].z };
+				// Calculate triangle screen bounds
+				fp minx, maxx;
+				if (screenx[0] < screenx[1])
+				{
+					minx = min(screenx[0], screenx[2]);
+					maxx = max(screenx[1], screenx[2]);
+				}
+				else
+				{
+					minx = min(screenx[1], screenx[2]);
+					maxx = max(screenx[0], screenx[2]);
+				}
+				//if the triangle is less than a pixel broad or out of reach then dont draw it.
+				if ((int)minx == (int)maxx || minx > this->width || maxx < 0) continue;
+				if (clipnear && rendersettings::s3d::backfaceculling::enabled)
+				{
+					if (!windedcorrect(activetri->screen[0].Get2d(), activetri->screen[1].Get2d(), activetri->screen[2].Get2d()))
+					{
+						continue;
+					}
+				}
+				int switchind[3];
+				switchy(switchind, screeny);
+				//if the triangle is less than a pixel heigh or is out of reach then dont fill it.
+				if ((int)screeny[switchind[0]] == (int)screeny[switchind[2]] || screeny[switchind[0]] > this->height || screeny[switchind[2]] < 0) continue;
 
-			fillTriangle3D(screenx[switchind[0]], screeny[switchind[0]], distance[switchind[0]],  activetri->t[switchind[0]], screenx[switchind[1]], screeny[switchind[1]], distance[switchind[1]], activetri->t[switchind[1]], screenx[switchind[2]], screeny[switchind[2]], distance[switchind[2]], activetri->t[switchind[2]], tex);
+				for (int pointIndex = 0; pointIndex < 3; pointIndex++)
+				{
+					screentri.x[pointIndex] = screenx[switchind[pointIndex]];
+					screentri.y[pointIndex] = screeny[switchind[pointIndex]];
+					screentri.d[pointIndex] = distance[switchind[pointIndex]];
+					screentri.w[pointIndex] = activetri->w[switchind[pointIndex]];
+					if (textured)
+					{
+						screentri.t[pointIndex] = activetri->t[switchind[pointIndex]];
+					}
+					if (lit)
+					{
+						screentri.l[pointIndex] = activetri->light[switchind[pointIndex]];
+					}
+				}
+				submitTriangle(screentri);
+			}
 		}
-	next:;//the next triangle will be drawn
 	}
-	delete[] vertices2D;
-	//}
+	if (!binner || !binner->batchDepth)
+	{
+		FlushTriangles();
+	}
+	//the binned triangles are copies, so the projected vertices are not needed anymore
+	ResetFrameArena();
 }
-//with textures and light levels
-//void graphicsObject::DrawTrianglesTex(fp* vertices, uint* indices, const uint& TriangleCount, const uint& VerticeCount, const vec3& position, mat4x4& view,const Texture& tex, const vec3& lookdirection) const
+//draws the same triangles once for every view matrix, transforming and binning all instances in one pass.
+//instancecolors: a color for every instance
+void graphicsObject::DrawTrianglesInstanced(const bufferobject<fp>* vertices, const bufferobject<uint>* indices, const mat4x4* views, const color* instancecolors, cint& instancecount) const
+{
+	DrawTrianglesShaded<shadingPlain>(vertices, indices, views, instancecount, [instancecolors](cint& instance, cint& triangleindex, cint* vertexindices, triangle& tri, binnedTriangle& screentri)
+		{
+			screentri.c = instancecolors[instance];
+		});
+}
+//multiplylight: 3 light levels per triangle, shared by all instances
+void graphicsObject::DrawTrianglesInstanced(const bufferobject<fp>* vertices, const bufferobject<fp>* multiplylight, const bufferobject<uint>* indices, const mat4x4* views, const color* instancecolors, cint& instancecount) const
+{
+	DrawTrianglesShaded<shadingPlainLight>(vertices, indices, views, instancecount, [multiplylight, instancecolors](cint& instance, cint& triangleindex, cint* vertexindices, triangle& tri, binnedTriangle& screentri)
+		{
+			cfp* lightPtr = multiplylight->buffer + triangleindex * multiplylight->stride;
+			for (int pointIndex = 0; pointIndex < 3; pointIndex++)
+			{
+				tri.light[pointIndex] = *(vec3*)(lightPtr + pointIndex * 3);
+			}
+			screentri.c = instancecolors[instance];
+		});
+}
+//all instances use the same texture and texture coordinates
+void graphicsObject::DrawTrianglesInstanced(const bufferobject<fp>* vertices, const bufferobject<fp>* texturecoords, const bufferobject<uint>* indices, const mat4x4* views, const Texture& tex, cint& instancecount) const
+{
+	DrawTrianglesShaded<shadingTexture>(vertices, indices, views, instancecount, [texturecoords, &tex](cint& instance, cint& triangleindex, cint* vertexindices, triangle& tri, binnedTriangle& screentri)
+		{
+			for (int pointIndex = 0; pointIndex < 3; pointIndex++)
+			{
+				tri.t[pointIndex] = *(vec2*)(texturecoords->buffer + vertexindices[pointIndex] * texturecoords->stride);
+			}
+			screentri.tex = &tex;
+		});
+}
+//with textures
 //vertices:
 //stepcount:the amount of vectors
 //stride:the stride of a vector
 //
-void graphicsObject::DrawTrianglesTexLight(const bufferobject<fp>* vertices, const bufferobject<fp>* texturecoords, const bufferobject<fp>* multiplylight, const bufferobject<uint>* indices, const vec3& position, const mat4x4& view, const Texture& tex, const vec3& lookdirection) const
+void graphicsObject::DrawTrianglesTex(const bufferobject<fp>* vertices, const bufferobject<fp>* texturecoords, const bufferobject<uint>* indices, const vec3& position, const mat4x4& view, const Texture& tex, const vec3& lookdirection) const
 {
-	vec3* const vertices2D = new vec3[vertices->stepcount];
-	//cint Stride = 3;//no need for texture indicing or light leveling
-	// vertices to 2D
-	vec3* p2d = vertices2D;
-	const fp* p3d = vertices->buffer;
-	const fp* end = p3d + vertices->stride * vertices->stepcount;
-	while (p3d < end)
-	{
-		*p2d++ = windowspace(view, *(vec3*)p3d);// - position);
-		p3d += vertices->stride;
-	}
-	cuint* indPtr = indices->buffer;
-	cfp* lightPtr = multiplylight->buffer;
-	for (
-		int i = 0;
-		i < indices->stepcount;
-		i++, indPtr += indices->stride, lightPtr += multiplylight->stride
-		)//iterate for each tri
-	{
-		// Get Values
-		cuint //get indices(they will be used multiple times)
-			indicevert0 = *indPtr,
-			indicevert1 = *(indPtr + 1),
-			indicevert2 = *(indPtr + 2);
-		triangle tris[2];//max count of clipped triangles is 2
-		//set first triangle
-		tris[0].p[0] = *(vec3*)(vertices->buffer + indicevert0 * vertices->stride);
-		tris[0].p[1] = *(vec3*)(vertices->buffer + indicevert1 * vertices->stride);
-		tris[0].p[2] = *(vec3*)(vertices->buffer + indicevert2 * vertices->stride);
-		tris[0].t[0] = *(vec2*)(texturecoords->buffer + indicevert0 * texturecoords->stride);
-		tris[0].t[1] = *(vec2*)(texturecoords->buffer + indicevert1 * texturecoords->stride);
-		tris[0].t[2] = *(vec2*)(texturecoords->buffer + indicevert2 * texturecoords->stride);
-		tris[0].light[0] = *(vec3*)(lightPtr);
-		tris[0].light[1] = *(vec3*)(lightPtr + 3);
-		tris[0].light[2] = *(vec3*)(lightPtr + 6);
-		tris[0].screen[0] = *(vertices2D + indicevert0);
-		tris[0].screen[1] = *(vertices2D + indicevert1);
-		tris[0].screen[2] = *(vertices2D + indicevert2);
-		triangle t = tris[0];//copy
-		int ClippedTriangleCount = Triangle_ClipAgainstScreen(view, t, tris[0], tris[1]);
-
-		//clippedtrianglecount can be zero, it will just skip this section.
-		for (int ClippedTriangleIndex = 0; ClippedTriangleIndex < ClippedTriangleCount; ClippedTriangleIndex++)
+	DrawTrianglesShaded<shadingTexture>(vertices, indices, &view, 1, [texturecoords, &tex](cint& instance, cint& triangleindex, cint* vertexindices, triangle& tri, binnedTriangle& screentri)
 		{
-			const triangle* activetri = (&tris[ClippedTriangleIndex]);
-			const fp screenx[3] = { activetri->screen[0].x, activetri->screen[1].x, activetri->screen[2].x };//screen coordinates
-			const fp screeny[3] = { activetri->screen[0].y, activetri->screen[1].y, activetri->screen[2].y };
-			const fp distance[3] = { activetri->screen[0].z, activetri->screen[1].z, activetri->screen[2].z };
-			// Calculate triangle screen bounds
-			fp minx, maxx;
-			if (screenx[0] < screenx[1])
+			for (int pointIndex = 0; pointIndex < 3; pointIndex++)
 			{
-				minx = min(screenx[0], screenx[2]);
-				maxx = max(screenx[1], screenx[2]);
+				tri.t[pointIndex] = *(vec2*)(texturecoords->buffer + vertexindices[pointIndex] * texturecoords->stride);
 			}
-			else
-			{
-				minx = min(screenx[1], screenx[2]);
-				maxx = max(screenx[0], screenx[2]);
-			}
-			//if the triangle is less than a pixel broad or out of reach then dont draw it.
-			if ((int)minx == (int)maxx || minx > this->width || maxx < 0) continue;
-			//https://stackoverflow.com/questions/9120032/determine-winding-of-a-2d-triangles-after-triangulation
-			if (rendersettings::s3d::backfaceculling::enabled)
+			screentri.tex = &tex;
+		});
+}
+//with textures and light levels
+//multiplylight: 3 light levels per triangle, 3 channels per light level
+void graphicsObject::DrawTrianglesTexLight(const bufferobject<fp>* vertices, const bufferobject<fp>* texturecoords, const bufferobject<fp>* multiplylight, const bufferobject<uint>* indices, const vec3& position, const mat4x4& view, const Texture& tex, const vec3& lookdirection) const
+{
+	DrawTrianglesShaded<shadingTextureLight>(vertices, indices, &view, 1, [texturecoords, multiplylight, &tex](cint& instance, cint& triangleindex, cint* vertexindices, triangle& tri, binnedTriangle& screentri)
+		{
+			cfp* lightPtr = multiplylight->buffer + triangleindex * multiplylight->stride;
+			for (int pointIndex = 0; pointIndex < 3; pointIndex++)
 			{
-				if (!windedcorrect(activetri->screen[0].Get2d(), activetri->screen[1].Get2d(), activetri->screen[2].Get2d()))
-				{
-					continue;
-				}
+				tri.t[pointIndex] = *(vec2*)(texturecoords->buffer + vertexindices[pointIndex] * texturecoords->stride);
+				tri.light[pointIndex] = *(vec3*)(lightPtr + pointIndex * 3);
 			}
-			int switchind[3];
-			switchy(switchind, screeny);
-			//if the triangle is less than a pixel heigh or is out of reach then dont fill it.
-			if ((int)screeny[switchind[0]] == (int)screeny[switchind[2]] || screeny[switchind[0]] > this->height || screeny[switchind[2]] < 0) continue;
-
-			fillTriangle3DLight(
-				screenx[switchind[0]], screeny[switchind[0]], distance[switchind[0]], activetri->t[switchind[0]],activetri->light[switchind[0]], 
-				screenx[switchind[1]], screeny[switchind[1]], distance[switchind[1]], activetri->t[switchind[1]], activetri->light[switchind[1]], 
-				screenx[switchind[2]], screeny[switchind[2]], distance[switchind[2]], activetri->t[switchind[2]],activetri->light[switchind[2]], tex);
-		}
-	next:;//the next triangle will be drawn
-	}
-	delete[] vertices2D;
+			screentri.tex = &tex;
+		});
 }
 //without textures
 void graphicsObject::DrawTrianglesPlain(const bufferobject<fp>* vertices, bufferobject<color>* tricolors, const bufferobject<uint>* indices, const vec3& position, const mat4x4& view, const vec3& lookdirection) const
 {
-	vec3* const vertices2D = new vec3[vertices->stepcount];
-	//cint Stride = 3;//no need for texture indicing or light leveling
-	// vertices to 2D
-	vec3* p2d = vertices2D;
-	const fp* p3d = vertices->buffer;
-	const fp* end = p3d + vertices->stride * vertices->stepcount;
-	while (p3d < end)
-	{
-		*p2d++ = windowspace(view, *(vec3*)p3d);// - position);
-		p3d += vertices->stride;
-	}
-	const uint* indPtr = indices->buffer;
-	const color* colorPtr = tricolors->buffer;
-	for (
-		int i = 0;
-		i<indices->stepcount;
-		i++,indPtr += indices->stride, colorPtr+=tricolors->stride
-		)//iterate for each tri
-	{
-		// Get Values
-		cint //get indices(they will be used multiple times)
-			indicevert0 = *indPtr,
-			indicevert1 = *(indPtr + 1),
-			indicevert2 = *(indPtr + 2);
-		triangle tris[2];//max count of clipped triangles is 2
-		//set first triangle
-		tris[0].p[0] = *(vec3*)(vertices->buffer + indicevert0 * vertices->stride);
-		tris[0].p[1] = *(vec3*)(vertices->buffer + indicevert1 * vertices->stride);
-		tris[0].p[2] = *(vec3*)(vertices->buffer + indicevert2 * vertices->stride);
-		tris[0].screen[0] = *(vertices2D + indicevert0);
-		tris[0].screen[1] = *(vertices2D + indicevert1);
-		tris[0].screen[2] = *(vertices2D + indicevert2);
-		triangle t = tris[0];//copy
-		int ClippedTriangleCount = Triangle_ClipAgainstScreen(view, t, tris[0], tris[1]);
-			
-		//clippedtrianglecount can be zero, it will just skip this section.
-		for (int ClippedTriangleIndex = 0; ClippedTriangleIndex < ClippedTriangleCount; ClippedTriangleIndex++)
+	DrawTrianglesShaded<shadingPlain>(vertices, indices, &view, 1, [tricolors](cint& instance, cint& triangleindex, cint* vertexindices, triangle& tri, binnedTriangle& screentri)
 		{
-			const triangle* activetri = (&tris[ClippedTriangleIndex]);
-			const fp screenx[3] = { activetri->screen[0].x, activetri->screen[1].x, activetri->screen[2].x };//screen coordinates
-			const fp screeny[3] = { activetri->screen[0].y, activetri->screen[1].y, activetri->screen[2].y };
-			const fp distance[3] = { activetri->screen[0].z, activetri->screen[1].z, activetri->screen[2].z };
-			// Calculate triangle screen bounds
-			fp minx, maxx;
-			if (screenx[0] < screenx[1])
-			{
-				minx = min(screenx[0],screenx[2]);
-				maxx = max(screenx[1],screenx[2]);
-			}
-			else
-			{
-				minx = min(screenx[1], screenx[2]);
-				maxx = max(screenx[0], screenx[2]);
-			}
-			//if the triangle is less than a pixel broad or out of reach then dont draw it.
-			if ((int)minx == (int)maxx || minx > this->width || maxx < 0) continue;
-			//https://stackoverflow.com/questions/9120032/determine-winding-of-a-2d-triangles-after-triangulation
-			if (rendersettings::s3d::backfaceculling::enabled)
-			{
-				if (!windedcorrect(activetri->screen[0].Get2d(), activetri->screen[1].Get2d(), activetri->screen[2].Get2d()))
-				{
-					continue;
-				}
-			}
-			int switchind[3];
-			switchy(switchind,screeny);
-			//if the triangle is less than a pixel heigh or is out of reach then dont fill it.
-			if ((int)screeny[switchind[0]] == (int)screeny[switchind[2]] || screeny[switchind[0]] > this->height || screeny[switchind[2]] < 0) continue;
-
-			fillTriangle3D(screenx[switchind[0]], screeny[switchind[0]], distance[switchind[0]], screenx[switchind[1]], screeny[switchind[1]], distance[switchind[1]], screenx[switchind[2]], screeny[switchind[2]], distance[switchind[2]], *colorPtr);
-		}
-	next:;//the next triangle will be drawn
-	}
-	delete[] vertices2D;
-	//}
+			screentri.c = tricolors->buffer[triangleindex * tricolors->stride];
+		});
 }
 
 //tricolors stride: 9 -> 3 colors per triangle and 3 channels per color
 void graphicsObject::DrawTrianglesPlainLight(const bufferobject<fp>* vertices, bufferobject<color>* tricolors, const bufferobject<fp>* multiplylight, const bufferobject<uint>* indices, const vec3& position, const mat4x4& view, const vec3& lookdirection) const
 {
-	vec3* const vertices2D = new vec3[vertices->stepcount];
-	//cint Stride = 3;//no need for texture indicing or light leveling
-	// vertices to 2D
-	vec3* p2d = vertices2D;
-	const fp* p3d = vertices->buffer;
-	const fp* end = p3d + vertices->stride * vertices->stepcount;
-	while (p3d < end)
-	{
-		*p2d++ = windowspace(view, *(vec3*)p3d);// - position);
-		p3d += vertices->stride;
-	}
-	const uint* indPtr = indices->buffer;
-	const color* colorPtr = tricolors->buffer;
-	const fp* lightPtr = multiplylight->buffer;
-	for (
-		int i = 0;
-		i < indices->stepcount;
-		i++, indPtr += indices->stride, colorPtr += tricolors->stride, lightPtr += multiplylight->stride
-		)//iterate for each tri
-	{
-		// Get Values
-		cint //get indices(they will be used multiple times)
-			indicevert0 = *indPtr,
-			indicevert1 = *(indPtr + 1),
-			indicevert2 = *(indPtr + 2);
-		triangle tris[2];//max count of clipped triangles is 2
-		//set first triangle
-		tris[0].p[0] = *(vec3*)(vertices->buffer + indicevert0 * vertices->stride);
-		tris[0].p[1] = *(vec3*)(vertices->buffer + indicevert1 * vertices->stride);
-		tris[0].p[2] = *(vec3*)(vertices->buffer + indicevert2 * vertices->stride);
-		tris[0].light[0] = *(vec3*)(lightPtr);
-		tris[0].light[1] = *(vec3*)(lightPtr + 3);
-		tris[0].light[2] = *(vec3*)(lightPtr + 6);
-		tris[0].screen[0] = *(vertices2D + indicevert0);
-		tris[0].screen[1] = *(vertices2D + indicevert1);
-		tris[0].screen[2] = *(vertices2D + indicevert2);
-		triangle t = tris[0];//copy
-		int ClippedTriangleCount = Triangle_ClipAgainstScreen(view, t, tris[0], tris[1]);
-
-		//clippedtrianglecount can be zero, it will just skip this section.
-		for (int ClippedTriangleIndex = 0; ClippedTriangleIndex < ClippedTriangleCount; ClippedTriangleIndex++)
+	DrawTrianglesShaded<shadingPlainLight>(vertices, indices, &view, 1, [tricolors, multiplylight](cint& instance, cint& triangleindex, cint* vertexindices, triangle& tri, binnedTriangle& screentri)
 		{
-			const triangle* activetri = (&tris[ClippedTriangleIndex]);
-			const fp screenx[3] = { activetri->screen[0].x, activetri->screen[1].x, activetri->screen[2].x };//screen coordinates
-			const fp screeny[3] = { activetri->screen[0].y, activetri->screen[1].y, activetri->screen[2].y };
-			const fp distance[3] = { activetri->screen[0].z, activetri->screen[1].z, activetri->screen[2].z };
-
-			// Calculate triangle screen bounds
-			fp minx, maxx;
-			if (screenx[0] < screenx[1])
+			cfp* lightPtr = multiplylight->buffer + triangleindex * multiplylight->stride;
+			for (int pointIndex = 0; pointIndex < 3; pointIndex++)
 			{
-				minx = min(screenx[0], screenx[2]);
-				maxx = max(screenx[1], screenx[2]);
+				tri.light[pointIndex] = *(vec3*)(lightPtr + pointIndex * 3);
 			}
-			else
-			{
-				minx = min(screenx[1], screenx[2]);
-				maxx = max(screenx[0], screenx[2]);
-			}
-			//if the triangle is less than a pixel broad or out of reach then dont draw it.
-			if ((int)minx == (int)maxx || minx > this->width || maxx < 0) continue;
-			//https://stackoverflow.com/questions/9120032/determine-winding-of-a-2d-triangles-after-triangulation
-			if (rendersettings::s3d::backfaceculling::enabled)
-			{
-				if (!windedcorrect(activetri->screen[0].Get2d(), activetri->screen[1].Get2d(), activetri->screen[2].Get2d()))
-				{
-					continue;
-				}
-			}
-			int switchind[3];
-			switchy(switchind, screeny);
-			//if the triangle is less than a pixel heigh or is out of reach then dont fill it.
-			if ((int)screeny[switchind[0]] == (int)screeny[switchind[2]] || screeny[switchind[0]] > this->height || screeny[switchind[2]] < 0) continue;
-
-			fillTriangle3DLight(
-				screenx[switchind[0]], screeny[switchind[0]], distance[switchind[0]], activetri->light[switchind[0]],
-				screenx[switchind[1]], screeny[switchind[1]], distance[switchind[1]], activetri->light[switchind[1]],
-				screenx[switchind[2]], screeny[switchind[2]], distance[switchind[2]], activetri->light[switchind[2]],
-				*colorPtr);
-		}
-	next:;//the next triangle will be drawn
-	}
-	delete[] vertices2D;
-	//}
+			screentri.c = tricolors->buffer[triangleindex * tricolors->stride];
+		});
 }
 
+void graphicsObject::SetClip(crectangle2i& rect) const
+{
+	cliprect = rect;
+	cliprect.crop(getClientRect());
+	//an empty rectangle instead of a negative size
+	cliprect.w = max(cliprect.w, 0);
+	cliprect.h = max(cliprect.h, 0);
+	clipping = true;
+}
+void graphicsObject::ResetClip() const
+{
+	clipping = false;
+}
 void graphicsObject::fillRectangle(cfp x, cfp y, cfp w, cfp h, const color c) const
 {
 	int ix = (int)x;
@@ -766,33 +710,22 @@ void graphicsObject::fillRectangle(crectangle2& rect, const color c) const
 }
 void graphicsObject::fillRectangle(rectangle2i rect, const color c) const
 {
-	rect.crop(getClientRect());
+	rect.crop(getDrawRect());
 	fillRectangleUnsafe(rect, c);
 }
 void graphicsObject::fillRectangle(rectangle2i rect, const brush* b) const
 {
-	rect.crop(getClientRect());
+	rect.crop(getDrawRect());
 	fillRectangleUnsafe(rect, b);
 }
 void graphicsObject::fillRectangleUnsafe(crectangle2i& rect, const brush* b) const
 {
 	color* ptr = colors + rect.x + rect.y * width;
-	color* EndPtrY = ptr + rect.h * width;
-	vec2 pos;
-	pos.y = rect.y;
-	while (ptr < EndPtrY)
+	cint endy = rect.y + rect.h;
+	for (int y = rect.y; y < endy; y++)
 	{
-		pos.x = rect.x;
-		color* NextY = ptr + width;
-		color* EndPtrX = ptr + rect.w;
-		while (ptr < EndPtrX)
-		{
-			*ptr = b->getColor(pos);
-			ptr++;
-			pos.x++;
-		}
-		pos.y++;
-		ptr = NextY;//ptr+=width of screen
+		b->fillSpan(y, rect.x, rect.x + rect.w, ptr);
+		ptr += width;//ptr+=width of screen
 	}
 }
 void graphicsObject::fillRectangleUnsafe(crectangle2i& rect, const color c) const
@@ -816,7 +749,7 @@ void graphicsObject::fillTexture(cvec2i& position, const Texture& tex) const
 {
 	//crop rectangle
 	rectangle2i rect = rectangle2i(position.x, position.y, tex.width, tex.height);
-	rect.crop(getClientRect());
+	rect.crop(getDrawRect());
 	fillTextureCropped(rect, tex.width, tex.colors);
 }
 //fill a scaled image
@@ -843,25 +776,12 @@ void graphicsObject::fillTexture(crectangle2& rect, cint& getw, cint& geth, cint
 }
 void graphicsObject::fillTextureCropped(crectangle2i& rect, cint imgwidth, const color* img) const
 {
+	const compositeFunction kernel = getCompositeKernel(rendersettings::checkopacity ? rendersettings::blendmode : blendCopy, rendersettings::compositekernel);
 	color* ptr = colors + rect.x + rect.y * width;
-	color* EndPtrY = ptr + rect.h * width;
 	const color* imgptr = img;
-	while (ptr < EndPtrY)
+	for (int j = 0; j < rect.h; j++, ptr += width, imgptr += imgwidth)
 	{
-		color* NextY = ptr + width;
-		const color* imgNextY = imgptr + imgwidth;
-		color* EndPtrX = ptr + rect.w;
-		while (ptr < EndPtrX)
-		{
-			if (!rendersettings::checkopacity || imgptr->a > 0)
-			{
-				*ptr = *imgptr;
-			}
-			ptr++;
-			imgptr++;
-		}
-		imgptr = imgNextY;
-		ptr = NextY;//ptr+=width of screen
+		kernel(ptr, imgptr, rect.w);
 	}
 }
 
@@ -872,10 +792,11 @@ void graphicsObject::fillTexture(cint& getw, cint& geth, cint& texWidth, const m
 	const vec2 pos10 = transform.multPointMatrix(vec2(getw, 0));
 	const vec2 pos01 = transform.multPointMatrix(vec2(0, geth));
 	const vec2 pos11 = transform.multPointMatrix(vec2(getw, geth));
-	int minX = (int)max(min(min(pos00.x, pos10.x), min(pos01.x, pos11.x)), 0),
-		maxX = (int)min(max(max(pos00.x, pos10.x), max(pos01.x, pos11.x)), width - 1),
-		minY = (int)max(min(min(pos00.y, pos10.y), min(pos01.y, pos11.y)), 0),
-		maxY = (int)min(max(max(pos00.y, pos10.y), max(pos01.y, pos11.y)), height - 1);
+	crectangle2i drawrect = getDrawRect();
+	int minX = (int)max(min(min(pos00.x, pos10.x), min(pos01.x, pos11.x)), drawrect.x),
+		maxX = (int)min(max(max(pos00.x, pos10.x), max(pos01.x, pos11.x)), drawrect.x + drawrect.w - 1),
+		minY = (int)max(min(min(pos00.y, pos10.y), min(pos01.y, pos11.y)), drawrect.y),
+		maxY = (int)min(max(max(pos00.y, pos10.y), max(pos01.y, pos11.y)), drawrect.y + drawrect.h - 1);
 	int dMinMaxX = maxX - minX;
 	int dMinMaxY = maxY - minY;
 	mat3x3 inverse = transform.Inverse();
@@ -883,23 +804,36 @@ void graphicsObject::fillTexture(cint& getw, cint& geth, cint& texWidth, const m
 	vec2 dy = vec2(inverse.myX, inverse.myY);
 	vec2 posj = inverse.multPointMatrix(vec2(minX, minY));
 	color* colorptr = colors + minX + minY * width;
+	const compositeFunction kernel = getCompositeKernel(rendersettings::checkopacity ? rendersettings::blendmode : blendCopy, rendersettings::compositekernel);
+	color texels[brushspansize];
 	for (int j = minY; j < maxY; j++,posj += dy)
 	{
 		vec2 posi = posj;
-		color* nextptr = colorptr + width;
-		
-		for (color* endptr = colorptr + dMinMaxX;colorptr < endptr; posi += dx,colorptr++)
+		int i = 0;
+		//the transform is affine, so the pixels of a row that are on the texture are one run
+		while (i < dMinMaxX && !(posi.x >= 0 && posi.x < getw && posi.y >= 0 && posi.y < geth))
 		{
-			if (posi.x >= 0 && posi.x < getw && posi.y >= 0 && posi.y < geth) 
+			i++;
+			posi += dx;
+		}
+		//gather the texels of the run in chunks and composite them with the row
+		while (i < dMinMaxX)
+		{
+			cint start = i;
+			int count = 0;
+			while (count < brushspansize && i < dMinMaxX && posi.x >= 0 && posi.x < getw && posi.y >= 0 && posi.y < geth)
 			{
-				color c = *(texColors + (int)posi.x + ((int)posi.y) * texWidth);
-				if (!rendersettings::checkopacity || c.a > 0)
-				{
-					*colorptr = c;
-				}
+				texels[count++] = *(texColors + (int)posi.x + ((int)posi.y) * texWidth);
+				i++;
+				posi += dx;
+			}
+			kernel(colorptr + start, texels, count);
+			if (count < brushspansize)
+			{
+				break;
 			}
 		}
-		colorptr = nextptr;
+		colorptr += width;
 	}
 }
 
@@ -915,12 +849,19 @@ graphicsObject::graphicsObject()
 {
 }
 
-graphicsObject::graphicsObject(cint& width, cint& height, color* colors, fp* depthbuffer)
+graphicsObject::graphicsObject(cint& width, cint& height, color* colors, void* depthbuffer, const depthFormat& depthformat)
 {
 	this->width = width;
 	this->height = height;
 	this->colors = colors;
 	this->depthbuffer = depthbuffer;
+	this->depthformat = depthformat;
+}
+graphicsObject::~graphicsObject()
+{
+	DeleteTileBins();
+	DeleteHiZ();
+	DeleteFrameArena();
 }
 graphicsObject::graphicsObject(cint& width, cint& height, bool generateDepthBuffer)
 {
@@ -944,11 +885,12 @@ graphicsObject* graphicsObject::FromImage(const Image& img)
 //copy colors and depthbuffer
 graphicsObject* graphicsObject::CopyObj(const graphicsObject& other)
 {
-	graphicsObject* g = new graphicsObject(other.width, other.height, new color[other.width * other.height], nullptr);
+	graphicsObject* g = new graphicsObject(other.width, other.height, new color[other.width * other.height], nullptr, other.depthformat);
 	std::memcpy(g->colors, other.colors, other.width * other.height * sizeof(color));
 	if (other.depthbuffer != nullptr) {
-		g->depthbuffer = new fp[other.width, other.height];
-		std::memcpy(g->depthbuffer, other.depthbuffer, other.width * other.height * sizeof(fp));
+		g->createDepthBuffer();
+		g->depthrange = other.depthrange;
+		std::memcpy(g->depthbuffer, other.depthbuffer, other.width * other.height * getDepthSize(other.depthformat));
 	}
 	return g;
 }
@@ -960,7 +902,26 @@ void graphicsObject::createColorBuffer()
 
 void graphicsObject::createDepthBuffer()
 {
-	depthbuffer = new fp[width * height]();
+	depthbuffer = calloc(width * height, getDepthSize(depthformat));
+	//the size can be changed, the hierarchical z buffer is recreated when needed
+	DeleteHiZ();
+}
+
+void graphicsObject::SetDepthFormat(const depthFormat& format)
+{
+	if (format != depthformat)
+	{
+		const bool hadDepthBuffer = depthbuffer != nullptr;
+		if (hadDepthBuffer)
+		{
+			DeleteDepthBuffer();
+		}
+		depthformat = format;
+		if (hadDepthBuffer)
+		{
+			createDepthBuffer();
+		}
+	}
 }
 
 void graphicsObject::DeleteColors() const
@@ -970,650 +931,563 @@ void graphicsObject::DeleteColors() const
 
 void graphicsObject::DeleteDepthBuffer() const
 {
-	delete[] depthbuffer;
+	free(depthbuffer);
 }
-//textured
-//conditions:
-//y0 < y1 < y2
-//https://github.com/ssloy/tinyrenderer/wiki/Lesson-2:-Triangle-rasterization-and-back-face-culling
-void graphicsObject::fillTriangle3D(const fp& x0, const fp& y0, const fp& d0, const vec2& tex0, const fp& x1, const fp& y1, const fp& d1, const vec2& tex1, const fp& x2, const fp& y2, const fp& d2, const vec2& tex2, const Texture& c) const
+void graphicsObject::DeleteTileBins() const
 {
-	cint y0Row = y0 > 0 ? fastceil(y0) : 0, maxy = y2 < height ? fastceil(y2) : height, maxsegment0y = y1 < height ? fastceil(y1) : height;
-
-	const fp x2x0 = x2 - x0;//dx from 0 to 2
-	const fp x1x0 = x1 - x0;//dx from 0 to 1
-	const fp x2x1 = x2 - x1;//dx from 1 to 2
-
-	const mat3x3 barcoords = Texture::GetBarycentricSet(vec2(x0, y0), vec2(x1, y1), vec2(x2, y2));
-	const fp total_height = y2 - y0;
-	fp segment_height = y1 - y0;
-	fp astep = x2x0 / total_height;//line 0 to 2
-	fp bstep = x1x0 / segment_height;//line 0 to 1
-	const fp minyy0 = (y0Row - y0);
-	fp A = x0 + astep * minyy0;//intersection from the left line with current y
-	fp B = x0 + bstep * minyy0;//intersection from the right line with current y
-
-
-	if (A > B) {
-		std::swap(A, B);//make a the left line, b the right line.
-		std::swap(astep, bstep);
+	delete binner;
+	binner = nullptr;
+}
+frameArena* graphicsObject::getFrameArena() const
+{
+	if (!arena)
+	{
+		arena = new frameArena();
 	}
-
-
-	int y = y0Row;
-	//calc values at (0,y0Row)
-	fp* ydepthptr = depthbuffer + y * width;
-	color* ycolorptr = colors + y * width;
-	fp depth00, depthxstep, depthystep;
-	Texture::getcoordfunction<fp>(d0, d1, d2, barcoords, depth00, depthxstep, depthystep);
-	vec2 tex00, texxstep, texystep;
-	Texture::getcoordfunction<vec2>(tex0, tex1, tex2, barcoords, tex00, texxstep, texystep);
-	fp depth0y = depth00 + depthystep * y0Row;
-	vec2 tex0y = tex00 + texystep * y0Row;
-	//fill top triangle(segment 0)
-	if (y < maxsegment0y)
+	return arena;
+}
+void graphicsObject::ResetFrameArena() const
+{
+	if (arena)
 	{
-	segment0loop:
-		cint activeminx = A > 0 ? ceil(A) : 0;//crop
-		cint activemaxx = B < width ? ceil(B) : width;
-		//calc values at(minx, miny)
-		fp depthxy = depth0y + activeminx * depthxstep;
-		vec2 texxy = tex0y + activeminx * texxstep;
-		fp* activedepthptr = ydepthptr + activeminx;
-		color* activecolorptr = ycolorptr + activeminx;
-		fp* endxptr = ydepthptr + activemaxx;
-		while (activedepthptr < endxptr) {//fill horizontal line of triangle
-
-			if (depthxy < *activedepthptr)
+		arena->reset();
+	}
+}
+size_t graphicsObject::EndArenaFrame() const
+{
+	return arena ? arena->endFrame() : 0;
+}
+void graphicsObject::DeleteFrameArena() const
+{
+	delete arena;
+	arena = nullptr;
+}
+void graphicsObject::DeleteHiZ() const
+{
+	delete hiz;
+	hiz = nullptr;
+}
+hiZBuffer* graphicsObject::getHiZ() const
+{
+	if (!hiz)
+	{
+		hiz = new hiZBuffer();
+	}
+	if (hiz->width != (width + hizblocksize - 1) / hizblocksize || hiz->height != (height + hizblocksize - 1) / hizblocksize)
+	{
+		hiz->resize(width, height);
+	}
+	return hiz;
+}
+fp graphicsObject::getHiZMaxDepth(cint& blockx, cint& blocky) const
+{
+	hiZBuffer* const h = getHiZ();
+	cint index = blockx + blocky * h->width;
+	if (h->dirty[index])
+	{
+		cint minx = blockx * hizblocksize, maxx = min(minx + hizblocksize, width);
+		cint miny = blocky * hizblocksize, maxy = min(miny + hizblocksize, height);
+		dispatchDepthBuffer([this, h, index, minx, maxx, miny, maxy](auto* const depthptr, cfp& scale)
 			{
-				if (depthxy < 0) {
-					depthxy++;
-				}
-				const color clr = c.getColor(texxy);
-				if (clr.a > 0 || !rendersettings::checkopacity)
+				auto highest = depthptr[minx + miny * width];
+				for (int y = miny; y < maxy; y++)
 				{
-					*activedepthptr = depthxy;
-					*activecolorptr = clr;
+					for (auto* ptr = depthptr + minx + y * width; ptr < depthptr + maxx + y * width; ptr++)
+					{
+						if (*ptr > highest)
+						{
+							highest = *ptr;
+						}
+					}
 				}
-			}
-			activedepthptr++;
-			activecolorptr++;
-			depthxy += depthxstep;
-			texxy += texxstep;
-		}
-		//increment y
-		//always increment
-		ydepthptr += width;
-		ycolorptr += width;
-		depth0y += depthystep;
-		tex0y += texystep;
-		if (++y < maxsegment0y)
-		{
-			A += astep;//only increment if the loop continues
-			B += bstep;
-			goto segment0loop;
-		}
+				h->maxdepth[index] = highest / scale;
+			});
+		h->dirty[index] = false;
 	}
-	
-	//we expect that y = maxsegment0y
-	segment_height = y2 - y1;
-	astep = x2x0 / total_height;//line 0 to 2
-	bstep = x2x1 / segment_height;//line 1 to 2
-	A = x0 + astep * (y - y0);
-	B = x1 + bstep * (y - y1);
-	if (A > B) {//make a the left line, b the right line.
-		std::swap(A, B);
-		std::swap(astep, bstep);
+	return h->maxdepth[index];
+}
+bool graphicsObject::isOccluded(crectangle2& screenrect, cfp& mindistance) const
+{
+	if (!depthbuffer)
+	{
+		return false;
 	}
-	//fill bottom triangle(segment 1)
-	if (y < maxy)
+	//the pixels that can be touched
+	cint minx = (int)floor(math::maximum(screenrect.x, (fp)0));
+	cint maxx = (int)floor(math::minimum(screenrect.x + screenrect.w, (fp)(width - 1)));
+	cint miny = (int)floor(math::maximum(screenrect.y, (fp)0));
+	cint maxy = (int)floor(math::minimum(screenrect.y + screenrect.h, (fp)(height - 1)));
+	for (int blocky = miny / hizblocksize; blocky <= maxy / hizblocksize; blocky++)
 	{
-	segment1loop:
-		int activeminx = A > 0 ? ceil(A) : 0;//crop
-		int activemaxx = B < width ? ceil(B) : width;
-		//calc values at(minx, miny)
-		fp* activedepthptr = ydepthptr + activeminx;
-		color* activecolorptr = ycolorptr + activeminx;
-		fp depthxy = depth0y + activeminx * depthxstep;
-		vec2 texxy = tex0y + activeminx * texxstep;
-		fp* endxptr = ydepthptr + activemaxx;
-		while (activedepthptr < endxptr) {//fill horizontal line of triangle
-			if (depthxy < *activedepthptr)
+		for (int blockx = minx / hizblocksize; blockx <= maxx / hizblocksize; blockx++)
+		{
+			if (mindistance < getHiZMaxDepth(blockx, blocky) * (1 + hiztolerance))
 			{
-				const color clr = c.getColor(texxy);
-				if (clr.a > 0 || !rendersettings::checkopacity)
-				{
-					*activedepthptr = depthxy;
-					*activecolorptr = clr;
-				}
+				return false;
 			}
-			activedepthptr++;
-			activecolorptr++;
-			depthxy += depthxstep;
-			texxy += texxstep;
-		}
-		if (++y < maxy)
-		{//increment y
-			A += astep;//only increment a and b if the loop continues.
-			B += bstep;
-			ydepthptr += width;//no need to increment y if y = maxy because this is the last segment
-			ycolorptr += width;
-			depth0y += depthystep;
-			tex0y += texystep;
-			goto segment1loop;
 		}
 	}
+	return true;
 }
-
-//textured
-//conditions:
-//y0 < y1 < y2
-//https://github.com/ssloy/tinyrenderer/wiki/Lesson-2:-Triangle-rasterization-and-back-face-culling
-void graphicsObject::fillTriangle3DLight(const fp& x0, const fp& y0, const fp& d0, const vec2& tex0, const vec3& l0, const fp& x1, const fp& y1, const fp& d1, const vec2& tex1, const vec3& l1, const fp& x2, const fp& y2, const fp& d2, const vec2& tex2, const vec3& l2, const Texture& c) const
+bool graphicsObject::isOccluded(const vec3* screenpoints, cint& count) const
 {
-	cint y0Row = y0 > 0 ? (int)ceil(y0) : 0, maxy = y2 < height ? (int)ceil(y2) : height, maxsegment0y = y1 < height ? (int)ceil(y1) : height;
-
-	const fp x2x0 = x2 - x0;//dx from 0 to 2
-	const fp x1x0 = x1 - x0;//dx from 0 to 1
-	const fp x2x1 = x2 - x1;//dx from 1 to 2
-
-	const mat3x3 barcoords = Texture::GetBarycentricSet(vec2(x0, y0), vec2(x1, y1), vec2(x2, y2));
-	const fp total_height = y2 - y0;
-	fp segment_height = y1 - y0;
-	fp astep = x2x0 / total_height;//line 0 to 2
-	fp bstep = x1x0 / segment_height;//line 0 to 1
-	const fp minyy0 = (y0Row - y0);
-	fp A = x0 + astep * minyy0;//intersection from the left line with current y
-	fp B = x0 + bstep * minyy0;//intersection from the right line with current y
-
-
-	if (A > B) {//x0 + x2x0 / 2 > x0 + x1x0 / 2 = x2x0 / 2 > x1x0 / 2 = x2x0 > x1x0
-		std::swap(A, B);//make a the left line, b the right line.
-		std::swap(astep, bstep);
+	if (!depthbuffer || count == 0)
+	{
+		return false;
 	}
-
-
-	int y = y0Row;
-	//calc values at (0,miny)
-	fp* ydepthptr = depthbuffer + y * width;
-	color* ycolorptr = colors + y * width;
-	fp depth00, depthxstep, depthystep;
-	Texture::getcoordfunction<fp>(d0, d1, d2, barcoords, depth00, depthxstep, depthystep);
-	vec2 tex00, texxstep, texystep;
-	Texture::getcoordfunction<vec2>(tex0, tex1, tex2, barcoords, tex00, texxstep, texystep);
-	vec3 light00, lightxstep, lightystep;
-	Texture::getcoordfunction<vec3>(l0, l1, l2, barcoords, light00, lightxstep, lightystep);
-	fp depth0y = depth00 + depthystep * y0Row;
-	vec2 tex0y = tex00 + texystep * y0Row;
-	vec3 light0y = light00 + lightystep * y0Row;
-	//fill top triangle(segment 0)
-	if (y < maxsegment0y)
+	vec2 pos00 = screenpoints->Get2d(), pos11 = pos00;
+	fp mindistance = screenpoints->z;
+	for (const vec3* point = screenpoints; point < screenpoints + count; point++)
 	{
-	segment0loop:
-		cint activeminx = A > 0 ? ceil(A) : 0;//crop
-		cint activemaxx = B < width ? ceil(B) : width;
-		//calc values at(minx, miny)
-		fp depthxy = depth0y + activeminx * depthxstep;
-		vec2 texxy = tex0y + activeminx * texxstep;
-		vec3 lightxy = light0y + activeminx * lightxstep;
-		fp* activedepthptr = ydepthptr + activeminx;
-		color* activecolorptr = ycolorptr + activeminx;
-		fp* endxptr = ydepthptr + activemaxx;
-		while (activedepthptr < endxptr) {//fill horizontal line of triangle
-			if (depthxy < *activedepthptr)
-			{
-				const color clrwithoutlight = c.getColor(texxy);
-				if (clrwithoutlight.a > 0 || !rendersettings::checkopacity)
-				{
-					const color clr = clrwithoutlight * lightxy;
-					*activedepthptr = depthxy;
-					*activecolorptr = clr;
-				}
-			}
-			activedepthptr++;
-			activecolorptr++;
-			depthxy += depthxstep;
-			texxy += texxstep;
-			lightxy += lightxstep;
+		//points behind the camera are not projected
+		if (point->z <= 0)
+		{
+			return false;
 		}
-		//increment y
-		//always increment
-		ydepthptr += width;
-		ycolorptr += width;
-		depth0y += depthystep;
-		tex0y += texystep;
-		light0y += lightystep;
-		if (++y < maxsegment0y)
+		pos00 = vec2(min(pos00.x, point->x), min(pos00.y, point->y));
+		pos11 = vec2(max(pos11.x, point->x), max(pos11.y, point->y));
+		mindistance = min(mindistance, point->z);
+	}
+	return isOccluded(rectangle2(pos00, pos11 - pos00), mindistance);
+}
+void graphicsObject::InvalidateHiZ(crectangle2i& rect) const
+{
+	if (hiz)
+	{
+		rectangle2i cropped = rect;
+		cropped.crop(getClientRect());
+		hiz->markDirty(cropped);
+	}
+}
+tileBinner* graphicsObject::getTileBinner() const
+{
+	if (!binner)
+	{
+		binner = new tileBinner();
+	}
+	if (binner->width != width || binner->height != height)
+	{
+		binner->resize(width, height);
+	}
+	return binner;
+}
+void graphicsObject::fillBinnedTriangle(const binnedTriangle& tri, crectangle2i& clip) const
+{
+	switch (tri.shading)
+	{
+	case shadingTexture:
+		fillTriangle3D(tri.x[0], tri.y[0], tri.d[0], tri.t[0], tri.x[1], tri.y[1], tri.d[1], tri.t[1], tri.x[2], tri.y[2], tri.d[2], tri.t[2], *tri.tex, clip, tri.w);
+		break;
+	case shadingTextureLight:
+		fillTriangle3DLight(
+			tri.x[0], tri.y[0], tri.d[0], tri.t[0], tri.l[0],
+			tri.x[1], tri.y[1], tri.d[1], tri.t[1], tri.l[1],
+			tri.x[2], tri.y[2], tri.d[2], tri.t[2], tri.l[2], *tri.tex, clip, tri.w);
+		break;
+	case shadingPlain:
+		fillTriangle3D(tri.x[0], tri.y[0], tri.d[0], tri.x[1], tri.y[1], tri.d[1], tri.x[2], tri.y[2], tri.d[2], tri.c, clip);
+		break;
+	case shadingPlainLight:
+		fillTriangle3DLight(
+			tri.x[0], tri.y[0], tri.d[0], tri.l[0],
+			tri.x[1], tri.y[1], tri.d[1], tri.l[1],
+			tri.x[2], tri.y[2], tri.d[2], tri.l[2], tri.c, clip, tri.w);
+		break;
+	}
+}
+void graphicsObject::submitTriangle(const binnedTriangle& tri) const
+{
+	if (rendersettings::s3d::occlusionculling)
+	{
+		cfp minx = min(min(tri.x[0], tri.x[1]), tri.x[2]);
+		cfp maxx = max(max(tri.x[0], tri.x[1]), tri.x[2]);
+		if (isOccluded(rectangle2(minx, tri.y[0], maxx - minx, tri.y[2] - tri.y[0]), min(min(tri.d[0], tri.d[1]), tri.d[2])))
 		{
-			A += astep;//only increment if the loop continues
-			B += bstep;
-			goto segment0loop;
+			return;
 		}
 	}
-
-	//we expect that y = maxsegment0y
-	segment_height = y2 - y1;
-	astep = x2x0 / total_height;//line 0 to 2
-	bstep = x2x1 / segment_height;//line 1 to 2
-	A = x0 + astep * (y - y0);
-	B = x1 + bstep * (y - y1);
-	//x0 + x2x0 * 0.5 > 
-	//x1 + x2x1 * 0.5
-
-	//
-
-	//x2x1 > x2x0
-
-	//A > B
-	if (A > B) {//make a the left line, b the right line.
-		std::swap(A, B);
-		std::swap(astep, bstep);
+	if (rendersettings::s3d::threadcount > 1 || (binner && binner->batchDepth))
+	{
+		getTileBinner()->add(tri);
+	}
+	else
+	{
+		fillBinnedTriangle(tri, getClientRect());
+	}
+}
+void graphicsObject::BeginTriangleBatch() const
+{
+	getTileBinner()->batchDepth++;
+}
+void graphicsObject::EndTriangleBatch() const
+{
+	if (--getTileBinner()->batchDepth == 0)
+	{
+		FlushTriangles();
 	}
-	//fill bottom triangle(segment 1)
-	if (y < maxy)
+}
+//every tile is filled by one thread, in the order the triangles were submitted.
+//the tiles do not overlap, so no locking is needed.
+void graphicsObject::FlushTriangles() const
+{
+	if (!binner || binner->triangles.size() == 0)
 	{
-	segment1loop:
-		int activeminx = A > 0 ? ceil(A) : 0;//crop
-		int activemaxx = B < width ? ceil(B) : width;
-		//calc values at(minx, miny)
-		fp* activedepthptr = ydepthptr + activeminx;
-		color* activecolorptr = ycolorptr + activeminx;
-		fp depthxy = depth0y + activeminx * depthxstep;
-		vec2 texxy = tex0y + activeminx * texxstep;
-		vec3 lightxy = light0y + activeminx * lightxstep;
-		fp* endxptr = ydepthptr + activemaxx;
-		while (activedepthptr < endxptr) {//fill horizontal line of triangle
-			if (depthxy < *activedepthptr)
+		return;
+	}
+	const tileBinner* const bins = binner;
+	getThreadPool(rendersettings::s3d::threadcount)->run((int)bins->tiles.size(), [this, bins](cint& index)
+		{
+			const std::vector<int>& tile = bins->tiles[index];
+			if (tile.size())
 			{
-				const color clrwithoutlight = c.getColor(texxy);
-				if (clrwithoutlight.a > 0 || !rendersettings::checkopacity)
+				crectangle2i clip = bins->getTileRect(index);
+				for (cint& triangleIndex : tile)
 				{
-					const color clr = clrwithoutlight * lightxy;
-					*activedepthptr = depthxy;
-					*activecolorptr = clr;
+					fillBinnedTriangle(bins->triangles[triangleIndex], clip);
 				}
 			}
-			activedepthptr++;
-			activecolorptr++;
-			depthxy += depthxstep;
-			texxy += texxstep;
-			lightxy += lightxstep;
+		});
+	binner->clear();
+}
+
+//calls fillSpan(y, minx, maxx) for every row part of the triangle inside the clip rectangle.
+//rows are split at tile borders and every span is calculated from its own coordinates,
+//so a triangle filled tile by tile fills exactly the same pixels as when it is filled at once.
+//conditions:
+//y0 <= y1 <= y2
+//https://github.com/ssloy/tinyrenderer/wiki/Lesson-2:-Triangle-rasterization-and-back-face-culling
+template<typename spanFunction>
+inline void forEachTriangleSpan(const fp& x0, const fp& y0, const fp& x1, const fp& y1, const fp& x2, const fp& y2, crectangle2i& clip, spanFunction fillSpan)
+{
+	cint clipright = clip.x + clip.w, cliptop = clip.y + clip.h;
+	cint miny = y0 > clip.y ? (int)ceil(y0) : clip.y, maxy = y2 < cliptop ? (int)ceil(y2) : cliptop;
+
+	const fp step02 = (x2 - x0) / (y2 - y0);//line 0 to 2
+	const fp step01 = y1 > y0 ? (x1 - x0) / (y1 - y0) : 0;//line 0 to 1
+	const fp step12 = y2 > y1 ? (x2 - x1) / (y2 - y1) : 0;//line 1 to 2
+	for (int y = miny; y < maxy; y++)
+	{
+		fp A = x0 + step02 * (y - y0);//intersection from the long line with current y
+		fp B = y < y1 ? x0 + step01 * (y - y0) : x1 + step12 * (y - y1);//intersection from the short lines with current y
+		if (A > B)
+		{
+			std::swap(A, B);//make a the left line, b the right line.
 		}
-		if (++y < maxy)
-		{//increment y
-			A += astep;//only increment a and b if the loop continues.
-			B += bstep;
-			ydepthptr += width;//no need to increment y if y = maxy because this is the last segment
-			ycolorptr += width;
-			depth0y += depthystep;
-			tex0y += texystep;
-			light0y += lightystep;
-			goto segment1loop;
+		int activeminx = A > clip.x ? (int)ceil(A) : clip.x;//crop
+		cint activemaxx = B < clipright ? (int)ceil(B) : clipright;
+		while (activeminx < activemaxx)
+		{
+			cint spanend = min(activemaxx, (activeminx / rendersettings::s3d::tilesize + 1) * rendersettings::s3d::tilesize);
+			fillSpan(y, activeminx, spanend);
+			activeminx = spanend;
 		}
 	}
 }
 
+//the pixels a triangle can touch, cropped to the clip rectangle
+inline rectangle2i getTriangleBounds(const fp& x0, const fp& y0, const fp& x1, const fp& y1, const fp& x2, const fp& y2, crectangle2i& clip)
+{
+	cint minx = (int)floor(math::maximum(min(min(x0, x1), x2), (fp)clip.x));
+	cint maxx = (int)floor(math::minimum(max(max(x0, x1), x2), (fp)(clip.x + clip.w - 1)));
+	cint miny = (int)floor(math::maximum(min(min(y0, y1), y2), (fp)clip.y));
+	cint maxy = (int)floor(math::minimum(max(max(y0, y1), y2), (fp)(clip.y + clip.h - 1)));
+	return rectangle2i(minx, miny, maxx - minx + 1, maxy - miny + 1);
+}
 
-
-//single color
 //conditions:
-//y0 < y1 < y2
-//https://github.com/ssloy/tinyrenderer/wiki/Lesson-2:-Triangle-rasterization-and-back-face-culling
-void graphicsObject::fillTriangle3D(const fp& x0, const fp& y0, const fp& d0, const fp& x1, const fp& y1, const fp& d1, const fp& x2, const fp& y2, const fp& d2, const color& c) const
+//y0 <= y1 <= y2
+template<typename samplerType, bool checkopacity, bool lit, bool perspective>
+void graphicsObject::fillTriangle3DShaded(
+	const fp& x0, const fp& y0, const fp& d0, const vec2& tex0, const vec3& l0,
+	const fp& x1, const fp& y1, const fp& d1, const vec2& tex1, const vec3& l1,
+	const fp& x2, const fp& y2, const fp& d2, const vec2& tex2, const vec3& l2,
+	const samplerType& sampler, crectangle2i& clip, const fp* w) const
 {
-	if(c.a < 0xff)
+	if (hiz)
 	{
-		fillTriangle3DOpacity(x0, y0, d0, x1, y1, d1, x2, y2, d2, c);
-		return;
+		hiz->markDirty(getTriangleBounds(x0, y0, x1, y1, x2, y2, clip));
 	}
-	cint y0Row = y0 > 0 ? (int)ceil(y0) : 0, maxy = y2 < height ? (int)ceil(y2) : height, maxsegment0y = y1 < height ? (int)ceil(y1) : height;
-
-	const fp x2x0 = x2 - x0;//dx from 0 to 2
-	const fp x1x0 = x1 - x0;//dx from 0 to 1
-	const fp x2x1 = x2 - x1;//dx from 1 to 2
-
 	const mat3x3 barcoords = Texture::GetBarycentricSet(vec2(x0, y0), vec2(x1, y1), vec2(x2, y2));
-	const fp total_height = y2 - y0;
-	fp segment_height = y1 - y0;
-	fp astep = x2x0 / total_height;//line 0 to 2
-	fp bstep = x1x0 / segment_height;//line 0 to 1
-	const fp minyy0 = (y0Row - y0);
-	fp A = x0 + astep * minyy0;//intersection from the left line with current y
-	fp B = x0 + bstep * minyy0;//intersection from the right line with current y
-
-
-	if (A > B) {
-		std::swap(A, B);//make a the left line, b the right line.
-		std::swap(astep, bstep);
-	}
-
-
-	int y = y0Row;
-	//calc values at (0,miny)
-	fp* ydepthptr = depthbuffer + y * width;
-	color* ycolorptr = colors + y * width;
 	fp depth00, depthxstep, depthystep;
 	Texture::getcoordfunction<fp>(d0, d1, d2, barcoords, depth00, depthxstep, depthystep);
-	fp depth0y = depth00 + depthystep * y0Row;
-	//fill top triangle(segment 0)
-	if (y < maxsegment0y)
+	//the attributes divided by w and 1 / w are linear in window space
+	const vec3 invw = perspective ? vec3(1 / w[0], 1 / w[1], 1 / w[2]) : vec3(1);
+	fp invw00 = 1, invwxstep = 0, invwystep = 0;
+	if (perspective)
+	{
+		Texture::getcoordfunction<fp>(invw.x, invw.y, invw.z, barcoords, invw00, invwxstep, invwystep);
+	}
+	vec2 tex00, texxstep, texystep;
+	Texture::getcoordfunction<vec2>(tex0 * invw.x, tex1 * invw.y, tex2 * invw.z, barcoords, tex00, texxstep, texystep);
+	vec3 light00, lightxstep, lightystep;
+	if (lit)
 	{
-	segment0loop:
-		cint activeminx = A > 0 ? ceil(A) : 0;//crop
-		cint activemaxx = B < width ? ceil(B) : width;
-		//calc values at(minx, miny)
-		fp depthxy = depth0y + activeminx * depthxstep;
-		fp* activedepthptr = ydepthptr + activeminx;
-		color* activecolorptr = ycolorptr + activeminx;
-		fp* endxptr = ydepthptr + activemaxx;
-		while (activedepthptr < endxptr) {//fill horizontal line of triangle
+		Texture::getcoordfunction<vec3>(l0 * invw.x, l1 * invw.y, l2 * invw.z, barcoords, light00, lightxstep, lightystep);
+	}
+	//the change of the texture coordinates per pixel, in the middle of the triangle when correcting for perspective
+	vec2 texdx = texxstep, texdy = texystep;
+	if (perspective)
+	{
+		cfp centerx = (x0 + x1 + x2) / 3, centery = (y0 + y1 + y2) / 3;
+		cfp centerinvw = invw00 + invwxstep * centerx + invwystep * centery;
+		const vec2 centertex = (tex00 + texxstep * centerx + texystep * centery) / centerinvw;
+		texdx = (texxstep - centertex * invwxstep) / centerinvw;
+		texdy = (texystep - centertex * invwystep) / centerinvw;
+	}
+	const samplerType activesampler = rendersettings::s3d::mipmapping ? selectMipLevel(sampler, texdx, texdy) : sampler;
 
-			if (depthxy < *activedepthptr)
+	dispatchDepthBuffer([&](auto* const depthptr, cfp& scale)
+		{
+			typedef std::remove_pointer_t<decltype(depthptr)> depthType;
+			//interpolate the stored values instead of the distances
+			const fp storeddepth00 = depth00 * scale, storeddepthxstep = depthxstep * scale, storeddepthystep = depthystep * scale;
+			if (rendersettings::s3d::rasterizer == rasterizeEdge)
 			{
-				*activedepthptr = depthxy;
-				*activecolorptr = c;
+				edgeSetup setup;
+				if (setup.setup(x0, y0, x1, y1, x2, y2, storeddepth00, storeddepthxstep, storeddepthystep, min(min(d0, d1), d2) * scale))
+				{
+					//the kernel already tested float depth buffers
+					const bool depthtested = getKernelDepthRow(depthptr) != nullptr;
+					forEachTriangleBlock(setup, clip, depthptr, width, [&](cint& y, cint& x, ull mask, const float* depths)
+						{
+							while (mask)
+							{
+								cint i = popLowestBit(mask);
+								cint px = x + i;
+								depthType* const activedepthptr = depthptr + px + y * width;
+								cfp depthxy = depthtested ? depths[i] : math::maximum(storeddepth00 + storeddepthystep * y + storeddepthxstep * px, setup.mindepth);
+								if (depthtested || depthxy < *activedepthptr)
+								{
+									cfp pixelw = perspective ? 1 / (invw00 + invwystep * y + invwxstep * px) : 1;
+									const vec2 texxy = tex00 + texystep * (fp)y + texxstep * (fp)px;
+									const color clr = activesampler.getColor(perspective ? texxy * pixelw : texxy);
+									if (!checkopacity || clr.a > 0)
+									{
+										*activedepthptr = toStoredDepth<depthType>(depthxy);
+										if (lit)
+										{
+											const vec3 lightxy = light00 + lightystep * (fp)y + lightxstep * (fp)px;
+											colors[px + y * width] = multiplyLight<checkopacity>(clr, perspective ? lightxy * pixelw : lightxy);
+										}
+										else
+										{
+											colors[px + y * width] = clr;
+										}
+									}
+								}
+							}
+						});
+				}
+				return;
 			}
-			activedepthptr++;
-			activecolorptr++;
-			depthxy += depthxstep;
-		}
-		//increment y
-		//always increment
-		ydepthptr += width;
-		ycolorptr += width;
-		depth0y += depthystep;
-		if (++y < maxsegment0y)
+			forEachTriangleSpan(x0, y0, x1, y1, x2, y2, clip, [&](cint& y, cint& minx, cint& maxx)
+				{
+					//calc values at(minx, y)
+					fp depthxy = storeddepth00 + storeddepthystep * y + storeddepthxstep * minx;
+					fp invwxy = invw00 + invwystep * y + invwxstep * minx;
+					vec2 texxy = tex00 + texystep * (fp)y + texxstep * (fp)minx;
+					vec3 lightxy = lit ? light00 + lightystep * (fp)y + lightxstep * (fp)minx : vec3();
+					depthType* activedepthptr = depthptr + minx + y * width;
+					color* activecolorptr = colors + minx + y * width;
+					depthType* const endxptr = activedepthptr + (maxx - minx);
+					while (activedepthptr < endxptr) {//fill horizontal line of triangle
+						if (depthxy < *activedepthptr)
+						{
+							cfp pixelw = perspective ? 1 / invwxy : 1;
+							const color clr = activesampler.getColor(perspective ? texxy * pixelw : texxy);
+							if (!checkopacity || clr.a > 0)
+							{
+								*activedepthptr = toStoredDepth<depthType>(depthxy);
+								*activecolorptr = lit ? multiplyLight<checkopacity>(clr, perspective ? lightxy * pixelw : lightxy) : clr;
+							}
+						}
+						activedepthptr++;
+						activecolorptr++;
+						depthxy += storeddepthxstep;
+						texxy += texxstep;
+						if (perspective)
+						{
+							invwxy += invwxstep;
+						}
+						if (lit)
+						{
+							lightxy += lightxstep;
+						}
+					}
+				});
+		});
+}
+
+//textured
+//conditions:
+//y0 <= y1 <= y2
+void graphicsObject::fillTriangle3D(const fp& x0, const fp& y0, const fp& d0, const vec2& tex0, const fp& x1, const fp& y1, const fp& d1, const vec2& tex1, const fp& x2, const fp& y2, const fp& d2, const vec2& tex2, const Texture& c, crectangle2i& clip, const fp* w) const
+{
+	const vec3 nolight = vec3();
+	const bool perspective = isPerspectiveCorrect(w);
+	dispatchSampler(c, [&](const auto& sampler)
 		{
-			A += astep;//only increment if the loop continues
-			B += bstep;
-			goto segment0loop;
-		}
-	}
+			typedef std::decay_t<decltype(sampler)> samplerType;
+			if (rendersettings::checkopacity)
+			{
+				if (perspective)
+				{
+					fillTriangle3DShaded<samplerType, true, false, true>(x0, y0, d0, tex0, nolight, x1, y1, d1, tex1, nolight, x2, y2, d2, tex2, nolight, sampler, clip, w);
+				}
+				else
+				{
+					fillTriangle3DShaded<samplerType, true, false, false>(x0, y0, d0, tex0, nolight, x1, y1, d1, tex1, nolight, x2, y2, d2, tex2, nolight, sampler, clip, w);
+				}
+			}
+			else
+			{
+				if (perspective)
+				{
+					fillTriangle3DShaded<samplerType, false, false, true>(x0, y0, d0, tex0, nolight, x1, y1, d1, tex1, nolight, x2, y2, d2, tex2, nolight, sampler, clip, w);
+				}
+				else
+				{
+					fillTriangle3DShaded<samplerType, false, false, false>(x0, y0, d0, tex0, nolight, x1, y1, d1, tex1, nolight, x2, y2, d2, tex2, nolight, sampler, clip, w);
+				}
+			}
+		});
+}
 
-	//we expect that y = maxsegment0y
-	segment_height = y2 - y1;
-	astep = x2x0 / total_height;//line 0 to 2
-	bstep = x2x1 / segment_height;//line 1 to 2
-	A = x0 + astep * (y - y0);
-	B = x1 + bstep * (y - y1);
-	if (A > B) {//make a the left line, b the right line.
-		std::swap(A, B);
-		std::swap(astep, bstep);
-	}
-	//fill bottom triangle(segment 1)
-	if (y < maxy)
-	{
-	segment1loop:
-		int activeminx = A > 0 ? ceil(A) : 0;//crop
-		int activemaxx = B < width ? ceil(B) : width;
-		//calc values at(minx, miny)
-		fp* activedepthptr = ydepthptr + activeminx;
-		color* activecolorptr = ycolorptr + activeminx;
-		fp depthxy = depth0y + activeminx * depthxstep;
-		fp* endxptr = ydepthptr + activemaxx;
-		while (activedepthptr < endxptr) {//fill horizontal line of triangle
-			if (depthxy < *activedepthptr)
+//textured with light levels
+//conditions:
+//y0 <= y1 <= y2
+void graphicsObject::fillTriangle3DLight(const fp& x0, const fp& y0, const fp& d0, const vec2& tex0, const vec3& l0, const fp& x1, const fp& y1, const fp& d1, const vec2& tex1, const vec3& l1, const fp& x2, const fp& y2, const fp& d2, const vec2& tex2, const vec3& l2, const Texture& c, crectangle2i& clip, const fp* w) const
+{
+	const bool perspective = isPerspectiveCorrect(w);
+	dispatchSampler(c, [&](const auto& sampler)
+		{
+			typedef std::decay_t<decltype(sampler)> samplerType;
+			if (rendersettings::checkopacity)
 			{
-				*activedepthptr = depthxy;
-				*activecolorptr = c;
+				if (perspective)
+				{
+					fillTriangle3DShaded<samplerType, true, true, true>(x0, y0, d0, tex0, l0, x1, y1, d1, tex1, l1, x2, y2, d2, tex2, l2, sampler, clip, w);
+				}
+				else
+				{
+					fillTriangle3DShaded<samplerType, true, true, false>(x0, y0, d0, tex0, l0, x1, y1, d1, tex1, l1, x2, y2, d2, tex2, l2, sampler, clip, w);
+				}
 			}
-			activedepthptr++;
-			activecolorptr++;
-			depthxy += depthxstep;
-		}
-		if (++y < maxy)
-		{//increment y
-			A += astep;//only increment a and b if the loop continues.
-			B += bstep;
-			ydepthptr += width;//no need to increment y if y = maxy because this is the last segment
-			ycolorptr += width;
-			depth0y += depthystep;
-			goto segment1loop;
-		}
-	}
+			else
+			{
+				if (perspective)
+				{
+					fillTriangle3DShaded<samplerType, false, true, true>(x0, y0, d0, tex0, l0, x1, y1, d1, tex1, l1, x2, y2, d2, tex2, l2, sampler, clip, w);
+				}
+				else
+				{
+					fillTriangle3DShaded<samplerType, false, true, false>(x0, y0, d0, tex0, l0, x1, y1, d1, tex1, l1, x2, y2, d2, tex2, l2, sampler, clip, w);
+				}
+			}
+		});
 }
-void graphicsObject::fillTriangle3DLight(
-	const fp& x0, const fp& y0, const fp& d0, const vec3& l0, 
-	const fp& x1, const fp& y1, const fp& d1, const vec3& l1, 
-	const fp& x2, const fp& y2, const fp& d2, const vec3& l2, 
-	const color& c) const
+
+//single color
+//conditions:
+//y0 <= y1 <= y2
+void graphicsObject::fillTriangle3D(const fp& x0, const fp& y0, const fp& d0, const fp& x1, const fp& y1, const fp& d1, const fp& x2, const fp& y2, const fp& d2, const color& c, crectangle2i& clip) const
 {
 	if (c.a < 0xff)
 	{
-		fillTriangle3DOpacity(x0, y0, d0, x1, y1, d1, x2, y2, d2, c);
+		fillTriangle3DOpacity(x0, y0, d0, x1, y1, d1, x2, y2, d2, c, clip);
 		return;
 	}
-	cint y0Row = y0 > 0 ? (int)ceil(y0) : 0, maxy = y2 < height ? (int)ceil(y2) : height, maxsegment0y = y1 < height ? (int)ceil(y1) : height;
-
-	const fp x2x0 = x2 - x0;//dx from 0 to 2
-	const fp x1x0 = x1 - x0;//dx from 0 to 1
-	const fp x2x1 = x2 - x1;//dx from 1 to 2
-
-	const mat3x3 barcoords = Texture::GetBarycentricSet(vec2(x0, y0), vec2(x1, y1), vec2(x2, y2));
-	const fp total_height = y2 - y0;
-	fp segment_height = y1 - y0;
-	fp astep = x2x0 / total_height;//line 0 to 2
-	fp bstep = x1x0 / segment_height;//line 0 to 1
-	const fp minyy0 = (y0Row - y0);
-	fp A = x0 + astep * minyy0;//intersection from the left line with current y
-	fp B = x0 + bstep * minyy0;//intersection from the right line with current y
-
-
-	if (A > B) {
-		std::swap(A, B);//make a the left line, b the right line.
-		std::swap(astep, bstep);
-	}
-
-
-	int y = y0Row;
-	//calc values at (0,miny)
-	fp* ydepthptr = depthbuffer + y * width;
-	color* ycolorptr = colors + y * width;
-
-	fp depth00, depthxstep, depthystep;
-	Texture::getcoordfunction<fp>(d0, d1, d2, barcoords, depth00, depthxstep, depthystep);
-	fp depth0y = depth00 + depthystep * y0Row;
-
-	vec3 light00, lightxstep, lightystep;
-	Texture::getcoordfunction<vec3>(l0, l1, l2, barcoords, light00, lightxstep, lightystep);
-	vec3 light0y = light00 + lightystep * y0Row;
+	const vec2 notex = vec2();
+	const vec3 nolight = vec3();
+	fillTriangle3DShaded<solidColorSampler, false, false, false>(x0, y0, d0, notex, nolight, x1, y1, d1, notex, nolight, x2, y2, d2, notex, nolight, solidColorSampler(c), clip, nullptr);
+}
 
-	//fill top triangle(segment 0)
-	if (y < maxsegment0y)
+//single color with light levels
+//conditions:
+//y0 <= y1 <= y2
+void graphicsObject::fillTriangle3DLight(
+	const fp& x0, const fp& y0, const fp& d0, const vec3& l0,
+	const fp& x1, const fp& y1, const fp& d1, const vec3& l1,
+	const fp& x2, const fp& y2, const fp& d2, const vec3& l2,
+	const color& c, crectangle2i& clip, const fp* w) const
+{
+	if (c.a < 0xff)
 	{
-	segment0loop:
-		cint activeminx = A > 0 ? ceil(A) : 0;//crop
-		cint activemaxx = B < width ? ceil(B) : width;
-		//calc values at(minx, miny)
-		fp depthxy = depth0y + activeminx * depthxstep;
-		vec3 lightxy = light0y + activeminx * lightxstep;
-		fp* activedepthptr = ydepthptr + activeminx;
-		color* activecolorptr = ycolorptr + activeminx;
-		fp* endxptr = ydepthptr + activemaxx;
-		while (activedepthptr < endxptr) {//fill horizontal line of triangle
-
-			if (depthxy < *activedepthptr)
-			{
-				*activedepthptr = depthxy;
-				*activecolorptr = c * lightxy;
-			}
-			activedepthptr++;
-			activecolorptr++;
-			depthxy += depthxstep;
-			lightxy += lightxstep;
-		}
-		//increment y
-		//always increment
-		ydepthptr += width;
-		ycolorptr += width;
-		depth0y += depthystep;
-		light0y += lightystep;
-		if (++y < maxsegment0y)
-		{
-			A += astep;//only increment if the loop continues
-			B += bstep;
-			goto segment0loop;
-		}
+		fillTriangle3DOpacity(x0, y0, d0, x1, y1, d1, x2, y2, d2, c, clip);
+		return;
 	}
-
-	//we expect that y = maxsegment0y
-	segment_height = y2 - y1;
-	astep = x2x0 / total_height;//line 0 to 2
-	bstep = x2x1 / segment_height;//line 1 to 2
-	A = x0 + astep * (y - y0);
-	B = x1 + bstep * (y - y1);
-	if (A > B) {//make a the left line, b the right line.
-		std::swap(A, B);
-		std::swap(astep, bstep);
+	//the color is opaque, so there is no alpha to test or keep
+	const vec2 notex = vec2();
+	if (isPerspectiveCorrect(w))
+	{
+		fillTriangle3DShaded<solidColorSampler, false, true, true>(x0, y0, d0, notex, l0, x1, y1, d1, notex, l1, x2, y2, d2, notex, l2, solidColorSampler(c), clip, w);
 	}
-	//fill bottom triangle(segment 1)
-	if (y < maxy)
+	else
 	{
-	segment1loop:
-		int activeminx = A > 0 ? ceil(A) : 0;//crop
-		int activemaxx = B < width ? ceil(B) : width;
-		//calc values at(minx, miny)
-		fp* activedepthptr = ydepthptr + activeminx;
-		color* activecolorptr = ycolorptr + activeminx;
-		fp depthxy = depth0y + activeminx * depthxstep;
-		vec3 lightxy = light0y + activeminx * lightxstep;
-		fp* endxptr = ydepthptr + activemaxx;
-		while (activedepthptr < endxptr) {//fill horizontal line of triangle
-			if (depthxy < *activedepthptr)
-			{
-				*activedepthptr = depthxy;
-				*activecolorptr = c * lightxy;
-			}
-			activedepthptr++;
-			activecolorptr++;
-			depthxy += depthxstep;
-			lightxy += lightxstep;
-		}
-		if (++y < maxy)
-		{//increment y
-			A += astep;//only increment a and b if the loop continues.
-			B += bstep;
-			ydepthptr += width;//no need to increment y if y = maxy because this is the last segment
-			ycolorptr += width;
-			depth0y += depthystep;
-			light0y += lightystep;
-			goto segment1loop;
-		}
+		fillTriangle3DShaded<solidColorSampler, false, true, false>(x0, y0, d0, notex, l0, x1, y1, d1, notex, l1, x2, y2, d2, notex, l2, solidColorSampler(c), clip, w);
 	}
 }
+
 //single transparent color
 //conditions:
-//y0 < y1 < y2
-//https://github.com/ssloy/tinyrenderer/wiki/Lesson-2:-Triangle-rasterization-and-back-face-culling
-void graphicsObject::fillTriangle3DOpacity(const fp& x0, const fp& y0, const fp& d0, const fp& x1, const fp& y1, const fp& d1, const fp& x2, const fp& y2, const fp& d2, const color& c) const
+//y0 <= y1 <= y2
+void graphicsObject::fillTriangle3DOpacity(const fp& x0, const fp& y0, const fp& d0, const fp& x1, const fp& y1, const fp& d1, const fp& x2, const fp& y2, const fp& d2, const color& c, crectangle2i& clip) const
 {
-	cint y0Row = y0 > 0 ? (int)ceil(y0) : 0, maxy = y2 < height ? (int)ceil(y2) : height, maxsegment0y = y1 < height ? (int)ceil(y1) : height;
-
+	if (hiz)
+	{
+		hiz->markDirty(getTriangleBounds(x0, y0, x1, y1, x2, y2, clip));
+	}
 	const fp weight = c.a * bytemult0to1;//opacity
-
-	const fp x2x0 = x2 - x0;//dx from 0 to 2
-	const fp x1x0 = x1 - x0;//dx from 0 to 1
-	const fp x2x1 = x2 - x1;//dx from 1 to 2
-
 	const mat3x3 barcoords = Texture::GetBarycentricSet(vec2(x0, y0), vec2(x1, y1), vec2(x2, y2));
-	const fp total_height = y2 - y0;
-	fp segment_height = y1 - y0;
-	fp astep = x2x0 / total_height;//line 0 to 2
-	fp bstep = x1x0 / segment_height;//line 0 to 1
-	const fp minyy0 = (y0Row - y0);
-	fp A = x0 + astep * minyy0;//intersection from the left line with current y
-	fp B = x0 + bstep * minyy0;//intersection from the right line with current y
-
-
-	if (A > B) {
-		std::swap(A, B);//make a the left line, b the right line.
-		std::swap(astep, bstep);
-	}
-
-
-	int y = y0Row;
-	//calc values at (0,miny)
-	fp* ydepthptr = depthbuffer + y * width;
-	color* ycolorptr = colors + y * width;
 	fp depth00, depthxstep, depthystep;
 	Texture::getcoordfunction<fp>(d0, d1, d2, barcoords, depth00, depthxstep, depthystep);
-	fp depth0y = depth00 + depthystep * y0Row;
-	//fill top triangle(segment 0)
-	if (y < maxsegment0y)
-	{
-	segment0loop:
-		cint activeminx = A > 0 ? ceil(A) : 0;//crop
-		cint activemaxx = B < width ? ceil(B) : width;
-		//calc values at(minx, miny)
-		fp depthxy = depth0y + activeminx * depthxstep;
-		fp* activedepthptr = ydepthptr + activeminx;
-		color* activecolorptr = ycolorptr + activeminx;
-		fp* endxptr = ydepthptr + activemaxx;
-		while (activedepthptr < endxptr) {//fill horizontal line of triangle
 
-			if (depthxy < *activedepthptr)
-			{
-				*activedepthptr = depthxy;
-				*activecolorptr = color::lerpcolor(*activecolorptr, c, weight);
-			}
-			activedepthptr++;
-			activecolorptr++;
-			depthxy += depthxstep;
-		}
-		//increment y
-		//always increment
-		ydepthptr += width;
-		ycolorptr += width;
-		depth0y += depthystep;
-		if (++y < maxsegment0y)
+	dispatchDepthBuffer([&](auto* const depthptr, cfp& scale)
 		{
-			A += astep;//only increment if the loop continues
-			B += bstep;
-			goto segment0loop;
-		}
-	}
-
-	//we expect that y = maxsegment0y
-	segment_height = y2 - y1;
-	astep = x2x0 / total_height;//line 0 to 2
-	bstep = x2x1 / segment_height;//line 1 to 2
-	A = x0 + astep * (y - y0);
-	B = x1 + bstep * (y - y1);
-	if (A > B) {//make a the left line, b the right line.
-		std::swap(A, B);
-		std::swap(astep, bstep);
-	}
-	//fill bottom triangle(segment 1)
-	if (y < maxy)
-	{
-	segment1loop:
-		int activeminx = A > 0 ? ceil(A) : 0;//crop
-		int activemaxx = B < width ? ceil(B) : width;
-		//calc values at(minx, miny)
-		fp* activedepthptr = ydepthptr + activeminx;
-		color* activecolorptr = ycolorptr + activeminx;
-		fp depthxy = depth0y + activeminx * depthxstep;
-		fp* endxptr = ydepthptr + activemaxx;
-		while (activedepthptr < endxptr) {//fill horizontal line of triangle
-			if (depthxy < *activedepthptr)
+			typedef std::remove_pointer_t<decltype(depthptr)> depthType;
+			const fp storeddepth00 = depth00 * scale, storeddepthxstep = depthxstep * scale, storeddepthystep = depthystep * scale;
+			if (rendersettings::s3d::rasterizer == rasterizeEdge)
 			{
-				*activedepthptr = depthxy;
-				*activecolorptr = color::lerpcolor(*activecolorptr, c, weight);
+				edgeSetup setup;
+				if (setup.setup(x0, y0, x1, y1, x2, y2, storeddepth00, storeddepthxstep, storeddepthystep, min(min(d0, d1), d2) * scale))
+				{
+					const bool depthtested = getKernelDepthRow(depthptr) != nullptr;
+					forEachTriangleBlock(setup, clip, depthptr, width, [&](cint& y, cint& x, ull mask, const float* depths)
+						{
+							while (mask)
+							{
+								cint px = x + popLowestBit(mask);
+								depthType* const activedepthptr = depthptr + px + y * width;
+								cfp depthxy = depthtested ? depths[px - x] : math::maximum(storeddepth00 + storeddepthystep * y + storeddepthxstep * px, setup.mindepth);
+								if (depthtested || depthxy < *activedepthptr)
+								{
+									*activedepthptr = toStoredDepth<depthType>(depthxy);
+									colors[px + y * width] = color::lerpcolor(colors[px + y * width], c, weight);
+								}
+							}
+						});
+				}
+				return;
 			}
-			activedepthptr++;
-			activecolorptr++;
-			depthxy += depthxstep;
-		}
-		if (++y < maxy)
-		{//increment y
-			A += astep;//only increment a and b if the loop continues.
-			B += bstep;
-			ydepthptr += width;//no need to increment y if y = maxy because this is the last segment
-			ycolorptr += width;
-			depth0y += depthystep;
-			goto segment1loop;
-		}
-	}
+			forEachTriangleSpan(x0, y0, x1, y1, x2, y2, clip, [&](cint& y, cint& minx, cint& maxx)
+				{
+					//calc values at(minx, y)
+					fp depthxy = storeddepth00 + storeddepthystep * y + storeddepthxstep * minx;
+					depthType* activedepthptr = depthptr + minx + y * width;
+					color* activecolorptr = colors + minx + y * width;
+					depthType* const endxptr = activedepthptr + (maxx - minx);
+					while (activedepthptr < endxptr) {//fill horizontal line of triangle
+						if (depthxy < *activedepthptr)
+						{
+							*activedepthptr = toStoredDepth<depthType>(depthxy);
+							*activecolorptr = color::lerpcolor(*activecolorptr, c, weight);
+						}
+						activedepthptr++;
+						activecolorptr++;
+						depthxy += storeddepthxstep;
+					}
+				});
+		});
 }
 //returns clipped triangles against the screen
 int graphicsObject::Triangle_ClipAgainstScreen(const mat4x4& view, triangle& in_tri, triangle& out_tri0, triangle& out_tri1) const
@@ -1630,6 +1504,8 @@ int graphicsObject::Triangle_ClipAgainstScreen(const mat4x4& view, triangle& in_
 	vec2* outside_tex[3];
 	vec3* inside_light[3];
 	vec3* outside_light[3];
+	fp* inside_w[3];
+	fp* outside_w[3];
 
 	//const bool PointInBack[3] = { in_tri.screen[0].z <= rendersettings::s3d::mindistance, in_tri.screen[1].z <= rendersettings::s3d::mindistance,in_tri.screen[2].z <= rendersettings::s3d::mindistance };//determines wether this point is behind the frustum
 	const bool PointInBack[3] = { in_tri.screen[0].z <= 0, in_tri.screen[1].z <= 0,in_tri.screen[2].z <= 0 };//determines wether this point is behind the frustum
@@ -1638,30 +1514,30 @@ int graphicsObject::Triangle_ClipAgainstScreen(const mat4x4& view, triangle& in_
 		if (PointInBack[0])//outside
 		{
 			if (PointInBack[1] && PointInBack[2])return 0;//too near
-			outside_points[outsidecount] = &in_tri.p[0]; outside_tex[outsidecount] = &in_tri.t[0]; outside_screen[outsidecount] = &in_tri.screen[0]; outside_light[outsidecount] = &in_tri.light[0];
+			outside_points[outsidecount] = &in_tri.p[0]; outside_tex[outsidecount] = &in_tri.t[0]; outside_screen[outsidecount] = &in_tri.screen[0]; outside_light[outsidecount] = &in_tri.light[0]; outside_w[outsidecount] = &in_tri.w[0];
 			outsidecount++;
 		}
 		else
 		{
-			inside_points[insidecount] = &in_tri.p[0]; inside_tex[insidecount] = &in_tri.t[0]; inside_screen[insidecount] = &in_tri.screen[0]; inside_light[insidecount] = &in_tri.light[0];
+			inside_points[insidecount] = &in_tri.p[0]; inside_tex[insidecount] = &in_tri.t[0]; inside_screen[insidecount] = &in_tri.screen[0]; inside_light[insidecount] = &in_tri.light[0]; inside_w[insidecount] = &in_tri.w[0];
 			insidecount++;
 		}
 		if (PointInBack[1])
 		{
-			outside_points[outsidecount] = &in_tri.p[1];  outside_tex[outsidecount] = &in_tri.t[1]; outside_screen[outsidecount] = &in_tri.screen[1]; outside_light[outsidecount] = &in_tri.light[1];
+			outside_points[outsidecount] = &in_tri.p[1];  outside_tex[outsidecount] = &in_tri.t[1]; outside_screen[outsidecount] = &in_tri.screen[1]; outside_light[outsidecount] = &in_tri.light[1]; outside_w[outsidecount] = &in_tri.w[1];
 			outsidecount++;
 		}
 		else
 		{
-			inside_points[insidecount] = &in_tri.p[1]; inside_tex[insidecount] = &in_tri.t[1]; inside_screen[insidecount] = &in_tri.screen[1]; inside_light[insidecount] = &in_tri.light[1];
+			inside_points[insidecount] = &in_tri.p[1]; inside_tex[insidecount] = &in_tri.t[1]; inside_screen[insidecount] = &in_tri.screen[1]; inside_light[insidecount] = &in_tri.light[1]; inside_w[insidecount] = &in_tri.w[1];
 			insidecount++;
 		}
 		if (PointInBack[2]) {
-			outside_points[outsidecount] = &in_tri.p[2];  outside_tex[outsidecount] = &in_tri.t[2]; outside_screen[outsidecount] = &in_tri.screen[2]; outside_light[outsidecount] = &in_tri.light[2];
+			outside_points[outsidecount] = &in_tri.p[2];  outside_tex[outsidecount] = &in_tri.t[2]; outside_screen[outsidecount] = &in_tri.screen[2]; outside_light[outsidecount] = &in_tri.light[2]; outside_w[outsidecount] = &in_tri.w[2];
 			outsidecount++;
 		}
 		else {
-			inside_points[insidecount] = &in_tri.p[2]; inside_tex[insidecount] = &in_tri.t[2]; inside_screen[insidecount] = &in_tri.screen[2]; inside_light[insidecount] = &in_tri.light[2];
+			inside_points[insidecount] = &in_tri.p[2]; inside_tex[insidecount] = &in_tri.t[2]; inside_screen[insidecount] = &in_tri.screen[2]; inside_light[insidecount] = &in_tri.light[2]; inside_w[insidecount] = &in_tri.w[2];
 			insidecount++;
 		}
 		if (PointInBack[0] == PointInBack[2] && PointInBack[0] != PointInBack[1]) 
@@ -1673,6 +1549,7 @@ int graphicsObject::Triangle_ClipAgainstScreen(const mat4x4& view, triangle& in_
 				std::swap(outside_tex[0], outside_tex[1]);
 				std::swap(outside_screen[0], outside_screen[1]);
 				std::swap(outside_light[0], outside_light[1]);
+				std::swap(outside_w[0], outside_w[1]);
 			}
 			else 
 			{
@@ -1680,6 +1557,7 @@ int graphicsObject::Triangle_ClipAgainstScreen(const mat4x4& view, triangle& in_
 				std::swap(inside_tex[0], inside_tex[1]);
 				std::swap(inside_screen[0], inside_screen[1]);
 				std::swap(inside_light[0], inside_light[1]);
+				std::swap(inside_w[0], inside_w[1]);
 			}
 			
 		}
@@ -1698,6 +1576,7 @@ int graphicsObject::Triangle_ClipAgainstScreen(const mat4x4& view, triangle& in_
 			out_tri0.screen[0] = *inside_screen[0];
 			out_tri0.t[0] = *inside_tex[0];
 			out_tri0.light[0] = *inside_light[0];
+			out_tri0.w[0] = *inside_w[0];
 
 			// but the two new points are at the locations where the 
 			// original sides of the triangle (lines) intersect with the screen
@@ -1705,11 +1584,13 @@ int graphicsObject::Triangle_ClipAgainstScreen(const mat4x4& view, triangle& in_
 			out_tri0.p[1] = lerp<vec3>(*inside_points[0], *outside_points[0], t);
 			out_tri0.t[1] = lerp<vec2>(*inside_tex[0], *outside_tex[0], t);
 			out_tri0.light[1] = lerp<vec3>(*inside_light [0] , *outside_light[0], t);
+			out_tri0.w[1] = lerp<fp>(*inside_w[0], *outside_w[0], t);
 
 			t = getw<fp>(inside_screen[0]->z, outside_screen[1]->z, 0);
 			out_tri0.p[2] = lerp<vec3>(*inside_points[0], *outside_points[1], t);
 			out_tri0.t[2] = lerp<vec2>(*inside_tex[0], *outside_tex[1], t);
 			out_tri0.light[2] = lerp<vec3>(*inside_light [0] , *outside_light[1], t);
+			out_tri0.w[2] = lerp<fp>(*inside_w[0], *outside_w[1], t);
 			//recalculate screen pos
 			out_tri0.screen[1] = windowspace(view, out_tri0.p[1]);
 			out_tri0.screen[2] = windowspace(view, out_tri0.p[2]);
@@ -1736,11 +1617,14 @@ int graphicsObject::Triangle_ClipAgainstScreen(const mat4x4& view, triangle& in_
 			out_tri0.t[1] = *inside_tex[1];
 			out_tri0.light[0] = *inside_light[0];
 			out_tri0.light[1] = *inside_light[1];
+			out_tri0.w[0] = *inside_w[0];
+			out_tri0.w[1] = *inside_w[1];
 
 			fp t = getw<fp>(inside_screen[0]->z, outside_screen[0]->z, 0);
 			out_tri0.p[2] = lerp<vec3>(*inside_points[0], *outside_points[0], t);
 			out_tri0.t[2] = lerp<vec2>(*inside_tex[0], *outside_tex[0], t);
 			out_tri0.light[2] = lerp<vec3>(*inside_light[0], *outside_light[0], t);
+			out_tri0.w[2] = lerp<fp>(*inside_w[0], *outside_w[0], t);
 
 			//recalculate screen pos
 			out_tri0.screen[2] = windowspace(view, out_tri0.p[2]);
@@ -1751,14 +1635,17 @@ int graphicsObject::Triangle_ClipAgainstScreen(const mat4x4& view, triangle& in_
 			out_tri1.screen[0] = *inside_screen[1];//0 = inside point
 			out_tri1.t[0] = *inside_tex[1];
 			out_tri1.light[0] = *inside_light[1];
+			out_tri1.w[0] = *inside_w[1];
 			out_tri1.screen[2] = out_tri0.screen[2];//1 = i0 * o0
 			out_tri1.t[2] = out_tri0.t[2];
 			out_tri1.light[2] = out_tri0.light[2];
+			out_tri1.w[2] = out_tri0.w[2];
 
 			t = getw<fp>(inside_screen[1]->z, outside_screen[0]->z, 0);
 			out_tri1.p[1] = lerp<vec3>(*inside_points[1], *outside_points[0], t);//2 = i1 * o0
 			out_tri1.t[1] = lerp<vec2>(*inside_tex[1], *outside_tex[0], t);
 			out_tri1.light[1] = lerp<vec3>(*inside_light[1], *outside_light[0], t);
+			out_tri1.w[1] = lerp<fp>(*inside_w[1], *outside_w[0], t);
 			//recalculate screen pos
 			out_tri1.screen[1] = windowspace(view, out_tri1.p[1]);
 
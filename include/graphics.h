@@ -6,12 +6,25 @@
 #include "triangle.h"
 #include "bufferobject.h"
 #include "array2d.h"
+#include "tilebinner.h"
+#include "threadpool.h"
+#include "samplers.h"
+#include "depthformat.h"
+#include "edgerasterizer.h"
+#include "hiz.h"
+#include "framearena.h"
+#include "vertextransform.h"
+#include "clipping.h"
+#include "compositing.h"
 
 namespace rendersettings {
 	extern bool checkopacity;
 	namespace s3d {
 		extern fp mindistance;
 		extern fp maxdistance;
+		//sample mipmapped textures from the level whose texels are closest to the size of the pixels of each triangle.
+		//squaretex::level is the most detailed level that is used.
+		extern bool mipmapping;
 		namespace backfaceculling 
 		{
 			extern bool enabled;
@@ -20,52 +33,145 @@ namespace rendersettings {
 	}
 }
 //multiply a color by a light level
+//keepalpha: keep the alpha of the color, else the result is opaque
+template<bool keepalpha>
+inline color multiplyLight(const color& c, cvec3& light);
+template<>
+inline color multiplyLight<true>(const color& c, cvec3& light)
+{
+	return color(c.a, (byte)(c.r * light.r), (byte)(c.g * light.g), (byte)(c.b * light.b));
+}
+template<>
+inline color multiplyLight<false>(const color& c, cvec3& light)
+{
+	return color((byte)(c.r * light.r), (byte)(c.g * light.g), (byte)(c.b * light.b));
+}
+//multiply a color by a light level
 inline color operator *(const color& c, cvec3& light)
 {
-	if (rendersettings::checkopacity)
-	{
-		return color(c.a, (byte)(c.r * light.r), (byte)(c.g * light.g), (byte)(c.b * light.b));
-	}
-	else
-	{
-		return color((byte)(c.r * light.r), (byte)(c.g * light.g), (byte)(c.b * light.b));
-	}
+	return rendersettings::checkopacity ? multiplyLight<true>(c, light) : multiplyLight<false>(c, light);
 }
 struct graphicsObject:public Texture
 {
-	//contains values between 0 and maxdistance
-	fp* depthbuffer = NULL;
+	//contains values between 0 and maxdistance, stored in depthformat.
+	//use GetDepth and SetDepth to read and write distances.
+	void* depthbuffer = NULL;
+	depthFormat depthformat = depthFloat32;
+	//the distance stored as the highest value in the normalized formats, set by ClearDepthBuffer
+	mutable fp depthrange = 1;
+	//the triangles waiting to be filled tile by tile, created when needed
+	mutable tileBinner* binner = nullptr;
+	//the highest distances of blocks of the depthbuffer, created when needed
+	mutable hiZBuffer* hiz = nullptr;
+	//the transient buffers of a draw call, created when needed and reset at the end of every draw call that uses it
+	mutable frameArena* arena = nullptr;
+	//the part of the screen the 2d drawing functions draw in, when clipping is on. set by SetClip
+	mutable rectangle2i cliprect = rectangle2i();
+	mutable bool clipping = false;
 
 	
 	virtual color getColor(const vec2& pos) const override;
+	virtual textureLayout getLayout() const override { return layoutLinear; }
 
 	//begin
 	graphicsObject();
-	graphicsObject(cint& width, cint& height, color* colors, fp* depthbuffer);
+	graphicsObject(cint& width, cint& height, color* colors, void* depthbuffer, const depthFormat& depthformat = depthFloat32);
 	graphicsObject(cint& width, cint& height, bool generateDepthBuffer);
+	//frees the tile bins, the hierarchical z buffer and the frame arena. the color and depth buffers are not owned.
+	~graphicsObject();
+	graphicsObject(const graphicsObject&) = delete;
+	graphicsObject& operator=(const graphicsObject&) = delete;
 	static graphicsObject* FromImage(const Image& img);
 	static graphicsObject* CopyObj(const graphicsObject& other);
 	
 	void createColorBuffer();
 	void createDepthBuffer();
+	//recreates the depthbuffer if there is one. the depth values are lost.
+	void SetDepthFormat(const depthFormat& format);
 
 	//end
 	void DeleteColors() const;
 	void DeleteDepthBuffer() const;
+	void DeleteTileBins() const;
+	void DeleteHiZ() const;
+	void DeleteFrameArena() const;
+	//releases the buffers of the last draw call. the draw calls that use the arena call this when they are done.
+	void ResetFrameArena() const;
+	//returns the most bytes one draw call allocated from the arena since the last call. call this once per frame.
+	size_t EndArenaFrame() const;
 
 	//set
-	void fillTriangle3D(const fp& x0, const fp& y0, const fp& d0, const vec2& tex0, const fp& x1, const fp& y1, const fp& d1, const vec2& tex1, const fp& x2, const fp& y2, const fp& d2, const vec2& tex2, const Texture& c) const;
-	void fillTriangle3DLight(const fp& x0, const fp& y0, const fp& d0, const vec2& tex0, const vec3& l0, const fp& x1, const fp& y1, const fp& d1, const vec2& tex1, const vec3& l1, const fp& x2, const fp& y2, const fp& d2, const vec2& tex2, const vec3& l2, const Texture& c) const;
-	void fillTriangle3D(const fp& x0, const fp& y0, const fp& d0, const fp& x1, const fp& y1, const fp& d1, const fp& x2, const fp& y2, const fp& d2, const color& c) const;
-	void fillTriangle3DLight(const fp& x0, const fp& y0, const fp& d0, const vec3& l0, const fp& x1, const fp& y1, const fp& d1, const vec3& l1, const fp& x2, const fp& y2, const fp& d2, const vec3& l2, const color& c) const;
-	void fillTriangle3DOpacity(const fp& x0, const fp& y0, const fp& d0, const fp& x1, const fp& y1, const fp& d1, const fp& x2, const fp& y2, const fp& d2, const color& c) const;
+	//the clip rectangle has to be inside the screen
+	//w: the clip space w of the 3 vertices, or nullptr. when given, the texture coordinates and light are interpolated perspective correct.
+	void fillTriangle3D(const fp& x0, const fp& y0, const fp& d0, const vec2& tex0, const fp& x1, const fp& y1, const fp& d1, const vec2& tex1, const fp& x2, const fp& y2, const fp& d2, const vec2& tex2, const Texture& c, crectangle2i& clip, const fp* w = nullptr) const;
+	void fillTriangle3DLight(const fp& x0, const fp& y0, const fp& d0, const vec2& tex0, const vec3& l0, const fp& x1, const fp& y1, const fp& d1, const vec2& tex1, const vec3& l1, const fp& x2, const fp& y2, const fp& d2, const vec2& tex2, const vec3& l2, const Texture& c, crectangle2i& clip, const fp* w = nullptr) const;
+	void fillTriangle3D(const fp& x0, const fp& y0, const fp& d0, const fp& x1, const fp& y1, const fp& d1, const fp& x2, const fp& y2, const fp& d2, const color& c, crectangle2i& clip) const;
+	void fillTriangle3DLight(const fp& x0, const fp& y0, const fp& d0, const vec3& l0, const fp& x1, const fp& y1, const fp& d1, const vec3& l1, const fp& x2, const fp& y2, const fp& d2, const vec3& l2, const color& c, crectangle2i& clip, const fp* w = nullptr) const;
+	void fillTriangle3DOpacity(const fp& x0, const fp& y0, const fp& d0, const fp& x1, const fp& y1, const fp& d1, const fp& x2, const fp& y2, const fp& d2, const color& c, crectangle2i& clip) const;
+	inline void fillTriangle3D(const fp& x0, const fp& y0, const fp& d0, const vec2& tex0, const fp& x1, const fp& y1, const fp& d1, const vec2& tex1, const fp& x2, const fp& y2, const fp& d2, const vec2& tex2, const Texture& c) const
+	{
+		fillTriangle3D(x0, y0, d0, tex0, x1, y1, d1, tex1, x2, y2, d2, tex2, c, getClientRect());
+	}
+	inline void fillTriangle3DLight(const fp& x0, const fp& y0, const fp& d0, const vec2& tex0, const vec3& l0, const fp& x1, const fp& y1, const fp& d1, const vec2& tex1, const vec3& l1, const fp& x2, const fp& y2, const fp& d2, const vec2& tex2, const vec3& l2, const Texture& c) const
+	{
+		fillTriangle3DLight(x0, y0, d0, tex0, l0, x1, y1, d1, tex1, l1, x2, y2, d2, tex2, l2, c, getClientRect());
+	}
+	inline void fillTriangle3D(const fp& x0, const fp& y0, const fp& d0, const fp& x1, const fp& y1, const fp& d1, const fp& x2, const fp& y2, const fp& d2, const color& c) const
+	{
+		fillTriangle3D(x0, y0, d0, x1, y1, d1, x2, y2, d2, c, getClientRect());
+	}
+	inline void fillTriangle3DLight(const fp& x0, const fp& y0, const fp& d0, const vec3& l0, const fp& x1, const fp& y1, const fp& d1, const vec3& l1, const fp& x2, const fp& y2, const fp& d2, const vec3& l2, const color& c) const
+	{
+		fillTriangle3DLight(x0, y0, d0, l0, x1, y1, d1, l1, x2, y2, d2, l2, c, getClientRect());
+	}
+	inline void fillTriangle3DOpacity(const fp& x0, const fp& y0, const fp& d0, const fp& x1, const fp& y1, const fp& d1, const fp& x2, const fp& y2, const fp& d2, const color& c) const
+	{
+		fillTriangle3DOpacity(x0, y0, d0, x1, y1, d1, x2, y2, d2, c, getClientRect());
+	}
+	//the shader all fill functions above use. the sampler and the tests are known at compile time,
+	//so the sampler can be inlined into the loop.
+	//checkopacity: skip pixels with an alpha of 0 and keep the alpha when lighting
+	//lit: multiply the colors by the interpolated light levels
+	//perspective: interpolate the texture coordinates and light divided by w, and divide them by the interpolated 1 / w per pixel.
+	//w: the clip space w of the vertices, only used when perspective is true
+	template<typename samplerType, bool checkopacity, bool lit, bool perspective>
+	void fillTriangle3DShaded(
+		const fp& x0, const fp& y0, const fp& d0, const vec2& tex0, const vec3& l0,
+		const fp& x1, const fp& y1, const fp& d1, const vec2& tex1, const vec3& l1,
+		const fp& x2, const fp& y2, const fp& d2, const vec2& tex2, const vec3& l2,
+		const samplerType& sampler, crectangle2i& clip, const fp* w) const;
+	void fillBinnedTriangle(const binnedTriangle& tri, crectangle2i& clip) const;
+	//fills the triangle directly, or bins it when rendering with multiple threads or when a batch is open
+	void submitTriangle(const binnedTriangle& tri) const;
+	//draw calls between BeginTriangleBatch and EndTriangleBatch are binned together and filled at once.
+	//the textures of the draw calls have to stay alive until the batch ends.
+	void BeginTriangleBatch() const;
+	void EndTriangleBatch() const;
+	//fills all binned triangles, using rendersettings::s3d::threadcount threads
+	void FlushTriangles() const;
+	tileBinner* getTileBinner() const;
+	hiZBuffer* getHiZ() const;
+	frameArena* getFrameArena() const;
+	//the highest distance in a block of the hierarchical z buffer, recalculated if it was drawn on
+	fp getHiZMaxDepth(cint& blockx, cint& blocky) const;
+	//returns true if nothing in the screen rectangle at mindistance or further away can be visible
+	bool isOccluded(crectangle2& screenrect, cfp& mindistance) const;
+	//returns true if no triangle between these window space points can be visible
+	bool isOccluded(const vec3* screenpoints, cint& count) const;
+	//call this after writing to the depthbuffer without SetDepth
+	void InvalidateHiZ(crectangle2i& rect) const;
 	int Triangle_ClipAgainstScreen(const mat4x4& view, triangle& in_tri, triangle& out_tri0, triangle& out_tri1) const;
 	void ClearDepthBuffer(cfp MaxDistance = rendersettings::s3d::maxdistance) const;
 	void Fog(color FogColor, cfp& multiplier = 1.0 / rendersettings::s3d::maxdistance) const;
+	template<triangleShading shading, typename attributeFunction>
+	void DrawTrianglesShaded(const bufferobject<fp>* vertices, const bufferobject<uint>* indices, const mat4x4* views, cint& instancecount, attributeFunction setAttributes) const;
 	void DrawTrianglesTex(const bufferobject<fp>* vertices, const bufferobject<fp>* texturecoords, const bufferobject<uint>* indices, const vec3& position, const mat4x4& view, const Texture& tex, const vec3& lookdirection) const;
 	void DrawTrianglesTexLight(const bufferobject<fp>* vertices, const bufferobject<fp>* texturecoords, const bufferobject<fp>* multiplylight, const bufferobject<uint>* indices, const vec3& position, const mat4x4& view, const Texture& tex, const vec3& lookdirection) const;
 	void DrawTrianglesPlain(const bufferobject<fp>* vertices, bufferobject<color>* tricolors, const bufferobject<uint>* indices, const vec3& position, const mat4x4& view, const vec3& lookdirection) const;
 	void DrawTrianglesPlainLight(const bufferobject<fp>* vertices, bufferobject<color>* tricolors, const bufferobject<fp>* multiplylight, const bufferobject<uint>* indices, const vec3& position, const mat4x4& view, const vec3& lookdirection) const;
+	void DrawTrianglesInstanced(const bufferobject<fp>* vertices, const bufferobject<uint>* indices, const mat4x4* views, const color* instancecolors, cint& instancecount) const;
+	void DrawTrianglesInstanced(const bufferobject<fp>* vertices, const bufferobject<fp>* multiplylight, const bufferobject<uint>* indices, const mat4x4* views, const color* instancecolors, cint& instancecount) const;
+	void DrawTrianglesInstanced(const bufferobject<fp>* vertices, const bufferobject<fp>* texturecoords, const bufferobject<uint>* indices, const mat4x4* views, const Texture& tex, cint& instancecount) const;
 	void ClearColor(const color BackGroundColor) const;
 	void drawRectangle(crectangle2i& rect, cint borderThickness, const color c) const;
 	void fill(const color c) const;
@@ -107,7 +213,42 @@ struct graphicsObject:public Texture
 
 	void SetDepthUnsafe(cint& x, cint& y, const fp& depth) const
 	{
-		depthbuffer[x + y * width] = depth;
+		cint index = x + y * width;
+		if (hiz)
+		{
+			hiz->markDirty(x, y);
+		}
+		switch (depthformat)
+		{
+		case depthFp:
+			((fp*)depthbuffer)[index] = depth;
+			break;
+		case depthFloat32:
+			((float*)depthbuffer)[index] = (float)depth;
+			break;
+		default:
+			((uint*)depthbuffer)[index] = toStoredDepth<uint>(math::minimum(math::maximum(depth, (fp)0), depthrange) * getDepthScale(depthformat, depthrange));
+			break;
+		}
+	}
+
+	//calls function(depthptr, scale) with a pointer of the type depthformat stores its values in.
+	//the stored values are the distances multiplied by scale.
+	template<typename depthFunction>
+	inline void dispatchDepthBuffer(depthFunction&& function) const
+	{
+		switch (depthformat)
+		{
+		case depthFp:
+			function((fp*)depthbuffer, (fp)1);
+			break;
+		case depthFloat32:
+			function((float*)depthbuffer, (fp)1);
+			break;
+		default:
+			function((uint*)depthbuffer, getDepthScale(depthformat, depthrange));
+			break;
+		}
 	}
 
 
@@ -117,7 +258,7 @@ struct graphicsObject:public Texture
 	{
 		//ViewFrustum f = ViewFrustum();
 		//f.update(view);
-		vec3* const vertices2D = new vec3[vertices->size / 3];
+		vec3* const vertices2D = getFrameArena()->allocate<vec3>(vertices->size / 3);
 		//cint Stride = 3;//no need for texture indicing or light leveling
 		// vertices to 2D
 		vec3* p2d = vertices2D;
@@ -141,8 +282,8 @@ struct graphicsObject:public Texture
 
 			//next:;//the next triangle will be drawn
 		}
-		delete[] vertices2D;
 		//}
+		ResetFrameArena();
 	}
 
 	inline void fillPixel3D(vec2 pos, cfp depth, color color) const
@@ -169,7 +310,8 @@ struct graphicsObject:public Texture
 	}
 	inline void fillPixel(cint x, cint y, color color) const
 	{
-		if (x >= 0 && y >= 0 && x < this->width && y < this->height)fillPixelUnsafe(x, y, color);
+		crectangle2i drawrect = getDrawRect();
+		if (x >= drawrect.x && y >= drawrect.y && x < drawrect.x + drawrect.w && y < drawrect.y + drawrect.h)fillPixelUnsafe(x, y, color);
 	}
 	inline void fillPixelUnsafe(cint& x, cint& y, const color& c) const
 	{
@@ -191,6 +333,14 @@ struct graphicsObject:public Texture
 	{
 		return rectangle2i(this->Size());
 	}
+	//the part of the screen the 2d drawing functions draw in
+	inline rectangle2i getDrawRect() const
+	{
+		return clipping ? cliprect : getClientRect();
+	}
+	//makes the 2d drawing functions only draw inside rect, until ResetClip is called
+	void SetClip(crectangle2i& rect) const;
+	void ResetClip() const;
 
 	// Return points in window space
 	//vec3(pixelx,pixely,distance)
@@ -0,0 +1,38 @@
+#include "hiz.h"
+
+bool rendersettings::s3d::occlusionculling = true;
+
+void hiZBuffer::resize(cint& pixelwidth, cint& pixelheight)
+{
+	width = (pixelwidth + hizblocksize - 1) / hizblocksize;
+	height = (pixelheight + hizblocksize - 1) / hizblocksize;
+	maxdepth = std::vector<fp>(width * height);
+	dirty = std::vector<byte>(width * height);
+	markAllDirty();
+}
+
+void hiZBuffer::reset(cfp& depth)
+{
+	std::fill(maxdepth.begin(), maxdepth.end(), depth);
+	std::fill(dirty.begin(), dirty.end(), false);
+}
+
+//the rectangle has to be inside the screen
+void hiZBuffer::markDirty(crectangle2i& pixelrect)
+{
+	if (pixelrect.w <= 0 || pixelrect.h <= 0)
+	{
+		return;
+	}
+	cint minx = pixelrect.x / hizblocksize, maxx = (pixelrect.x + pixelrect.w - 1) / hizblocksize;
+	cint miny = pixelrect.y / hizblocksize, maxy = (pixelrect.y + pixelrect.h - 1) / hizblocksize;
+	for (int y = miny; y <= maxy; y++)
+	{
+		std::fill(dirty.begin() + minx + y * width, dirty.begin() + maxx + 1 + y * width, true);
+	}
+}
+
+void hiZBuffer::markAllDirty()
+{
+	std::fill(dirty.begin(), dirty.end(), true);
+}
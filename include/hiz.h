@@ -0,0 +1,42 @@
+#pragma once
+#include "GlobalFunctions.h"
+#include "rectangle2.h"
+
+namespace rendersettings
+{
+	namespace s3d
+	{
+		//reject triangles and meshes that are behind everything drawn in their screen area before filling them
+		extern bool occlusionculling;
+	}
+}
+
+//the width and height of a block of pixels in the hierarchical z buffer
+constexpr int hizblocksize = 8;
+//triangles are only rejected when they are this much further away than the blocks, because the depths in the buffer are rounded
+constexpr fp hiztolerance = 1e-5;
+
+//a coarse depth buffer with the highest distance of every block of pixels.
+//a triangle that is further away than the highest distance of all blocks it touches can not be visible.
+//the blocks are recalculated from the depth buffer when they are needed after something was drawn on them.
+//https://www.rastergrid.com/blog/2010/10/hierarchical-z-map-based-occlusion-culling/
+struct hiZBuffer
+{
+	//the size in blocks
+	int width = 0;
+	int height = 0;
+	//the highest distance of every block, only valid when the block is not dirty
+	std::vector<fp> maxdepth;
+	//the blocks that were drawn on since they were calculated.
+	//bytes instead of bits, so different threads can mark blocks in different tiles.
+	std::vector<byte> dirty;
+	void resize(cint& pixelwidth, cint& pixelheight);
+	//after clearing the depth buffer to this distance
+	void reset(cfp& depth);
+	void markDirty(crectangle2i& pixelrect);
+	inline void markDirty(cint& x, cint& y)
+	{
+		dirty[x / hizblocksize + (y / hizblocksize) * width] = true;
+	}
+	void markAllDirty();
+};
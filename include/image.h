@@ -42,6 +42,7 @@ public:
 	static Image* FromFile(std::wstring path, const bool flip);
 	void Save(std::wstring path);
 	color getColor(const vec2& pos) const override;
+	virtual textureLayout getLayout() const override { return layoutLinear; }
 private:
 
 };
\ No newline at end of file
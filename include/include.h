@@ -15,7 +15,11 @@
 #include "array2d.h"
 #include "MarchingCubes.h"
 #include "mesh.h"
+#include "scene.h"
+#include "drawcommands.h"
+#include "postprocess.h"
 #include "keyframe.h"
+#include "animation.h"
 #include "dimensionallist.h"
 #include "rectangle3.h"
 #include "ai.h"
@@ -27,16 +27,18 @@ struct transition
 		{
 			return (*keyframes)[0]->value;
 		}
-		for (int i = 1; i < keyframes->size();i++)
-		{
-			keyframe<t>* currentkeyframe = (*keyframes)[i];
-			if (currentkeyframe->location >= location)
+		//the first keyframe at or after the location
+		auto current = std::lower_bound(keyframes->begin() + 1, keyframes->end(), location, [](const keyframe<t>* key, cfp& location)
 			{
-				keyframe<t>* lastkeyframe = (*keyframes)[i - 1];
-				//interpolate
-				cfp weight = getw(lastkeyframe->location, currentkeyframe->location, location);
-				return lerp(lastkeyframe->value, currentkeyframe->value, weight);
-			}
+				return key->location < location;
+			});
+		if (current != keyframes->end())
+		{
+			keyframe<t>* currentkeyframe = *current;
+			keyframe<t>* lastkeyframe = *(current - 1);
+			//interpolate
+			cfp weight = getw(lastkeyframe->location, currentkeyframe->location, location);
+			return lerp(lastkeyframe->value, currentkeyframe->value, weight);
 		}
 		return ((*keyframes)[KeyframeCount - 1])->value;
 	}
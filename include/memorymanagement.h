@@ -18,7 +18,7 @@ cint TypeSpace[StandardTypeCount]
 	0,//void costs 0 bytes of memory because it is nothing.
 	1,//boolean costs 1 byte of memory.
 	4,//int costs 4 bytes of memory.
-	8,//fp costs 8 bytes of memory.
+	sizeof(fp),//fp costs 4, 8 or 16 bytes of memory, depending on the precision.
 };
 inline types GetType(std::wstring typeN) 
 {
@@ -1,5 +1,7 @@
 #include "mesh.h"
 
+bool rendersettings::s3d::frustumculling = true;
+
 bufferobject<uint>* mesh::GenerateIndiceBuffer(cuint size)
 {
 	uint* elements = new uint[size];
@@ -130,4 +132,15 @@ void mesh::ApplyMatrix(mat4x4 mat)
 			*cur = mat.multPointMatrix(*cur);
 		}
 	}
+	InvalidateBounds();
+}
+
+const AABB& mesh::getBounds() const
+{
+	if (!boundsValid)
+	{
+		bounds = AABB::fromVertices(vertices);
+		boundsValid = true;
+	}
+	return bounds;
 }
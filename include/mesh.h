@@ -1,7 +1,17 @@
 #include "graphics.h"
 #include "fastlist.h"
+#include "frustum.h"
 #pragma once
 
+namespace rendersettings
+{
+	namespace s3d
+	{
+		//skip meshes whose bounding box is outside the view frustum
+		extern bool frustumculling;
+	}
+}
+
 struct mesh 
 {
 	static bufferobject<uint>* GenerateIndiceBuffer(cuint size);
@@ -27,8 +37,26 @@ struct mesh
 	bufferobject<uint>* indices = nullptr;//the indices that you want to draw
 	bufferobject<color>* colors = nullptr;//if you want to draw in plain colors
 	Texture* tex = nullptr;
-	inline void Draw(const graphicsObject* graphics, const vec3& position, const mat4x4& view, const vec3& lookdirection) const
+	//the box around the vertices, calculated when needed
+	const AABB& getBounds() const;
+	//call this after changing the vertices
+	inline void InvalidateBounds()
+	{
+		boundsValid = false;
+	}
+	//returns false if the mesh was outside the view frustum and nothing was drawn
+	inline bool Draw(const graphicsObject* graphics, const vec3& position, const mat4x4& view, const vec3& lookdirection) const
 	{
+		if (rendersettings::s3d::frustumculling)
+		{
+			//the frustum of the view matrix is in the space of the vertices, so the bounds do not have to be transformed
+			ViewFrustum frustum = ViewFrustum();
+			frustum.update(view);
+			if (!frustum.isBoxInFrustum(getBounds()))
+			{
+				return false;
+			}
+		}
 		if (textureCoordinates && tex) 
 		{
 			if (lightLevels) 
@@ -51,5 +79,9 @@ struct mesh
 				graphics->DrawTrianglesPlain(vertices, colors, indices, position, view, lookdirection);
 			}
 		}
+		return true;
 	}
+private:
+	mutable AABB bounds;
+	mutable bool boundsValid = false;
 };
\ No newline at end of file
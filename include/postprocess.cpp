@@ -0,0 +1,193 @@
+#include "postprocess.h"
+
+void postProcess::AddClearColor(const color& c)
+{
+	postStage stage;
+	stage.type = stageClearColor;
+	stage.c = c;
+	stages.push_back(stage);
+}
+void postProcess::AddClearDepth(cfp& maxdistance)
+{
+	postStage stage;
+	stage.type = stageClearDepth;
+	stage.value = maxdistance;
+	stages.push_back(stage);
+}
+void postProcess::AddFog(const color& fogcolor, cfp& multiplier)
+{
+	postStage stage;
+	stage.type = stageFog;
+	stage.c = fogcolor;
+	stage.value = multiplier;
+	stages.push_back(stage);
+}
+void postProcess::AddFade(cfp& weight, const color& fadeto)
+{
+	postStage stage;
+	stage.type = stageFade;
+	stage.c = fadeto;
+	stage.value = weight;
+	stages.push_back(stage);
+}
+void postProcess::AddMultiply(cfp& multiplier)
+{
+	postStage stage;
+	stage.type = stageMultiply;
+	stage.value = multiplier;
+	stages.push_back(stage);
+}
+void postProcess::AddCustom(postRowFunction function, void* data)
+{
+	postStage stage;
+	stage.type = stageCustom;
+	stage.function = function;
+	stage.data = data;
+	stages.push_back(stage);
+}
+void postProcess::Clear()
+{
+	stages.clear();
+}
+
+//a weight from 0 to 1 as 8.8 fixed point
+inline int getFixedWeight(cfp& weight)
+{
+	return (int)(math::minimum(math::maximum(weight, (fp)0), (fp)1) * 0x100);
+}
+
+//blends 2 pixels, 16 bits per channel, to target by weights from 0 to 0x100
+inline __m128i blendChannels(const __m128i& channels, const __m128i& target, const __m128i& weights)
+{
+	//at most 0xff * 0x100, so the sum fits in 16 bits unsigned
+	return _mm_srli_epi16(_mm_add_epi16(
+		_mm_mullo_epi16(channels, _mm_sub_epi16(_mm_set1_epi16(0x100), weights)),
+		_mm_mullo_epi16(target, weights)), 8);
+}
+
+//blends count pixels to target, 4 pixels at a time. the pixels become opaque, like color::lerpcolor.
+//weights: a weight from 0 to 0x100 for every pixel, or nullptr to use weight for all pixels.
+inline void blendRow(color* row, cint& count, const color& target, const int* weights, cint& weight = 0)
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i opaque = _mm_set1_epi32((int)0xff000000);
+	//2 pixels in 16 bits per channel
+	const __m128i targetchannels = _mm_unpacklo_epi8(_mm_set1_epi32(target.val), zero);
+	const __m128i uniformweights = _mm_set1_epi16((short)weight);
+	int i = 0;
+	for (; i + 4 <= count; i += 4)
+	{
+		const __m128i pixels = _mm_loadu_si128((const __m128i*)(row + i));
+		__m128i lowweights = uniformweights, highweights = uniformweights;
+		if (weights)
+		{
+			//w0 w1 w2 w3 to w0 w0 w0 w0 w1 w1 w1 w1 and w2 w2 w2 w2 w3 w3 w3 w3
+			const __m128i packed = _mm_packs_epi32(_mm_loadu_si128((const __m128i*)(weights + i)), zero);
+			const __m128i pairs = _mm_unpacklo_epi16(packed, packed);
+			lowweights = _mm_unpacklo_epi32(pairs, pairs);
+			highweights = _mm_unpackhi_epi32(pairs, pairs);
+		}
+		const __m128i low = blendChannels(_mm_unpacklo_epi8(pixels, zero), targetchannels, lowweights);
+		const __m128i high = blendChannels(_mm_unpackhi_epi8(pixels, zero), targetchannels, highweights);
+		_mm_storeu_si128((__m128i*)(row + i), _mm_or_si128(_mm_packus_epi16(low, high), opaque));
+	}
+	for (; i < count; i++)
+	{
+		cint pixelweight = weights ? weights[i] : weight;
+		cint pixelsweight = 0x100 - pixelweight;
+		row[i] = color(
+			(byte)((row[i].r * pixelsweight + target.r * pixelweight) >> 8),
+			(byte)((row[i].g * pixelsweight + target.g * pixelweight) >> 8),
+			(byte)((row[i].b * pixelsweight + target.b * pixelweight) >> 8));
+	}
+}
+
+//the fog weights of a row. the depths are converted to floats, so the loop can be vectorized.
+template<typename depthType>
+inline void getFogWeights(const depthType* depthrow, cint& count, cfp& storedmultiplier, int* weights)
+{
+	const float multiplier = (float)(storedmultiplier * 0x100);
+	for (int i = 0; i < count; i++)
+	{
+		weights[i] = (int)min(max((float)depthrow[i] * multiplier, 0.0f), (float)0x100);
+	}
+}
+
+void postProcess::Apply(const graphicsObject& graphics) const
+{
+	if (stages.size() == 0 || graphics.width == 0 || graphics.height == 0)
+	{
+		return;
+	}
+	//the value a distance is multiplied by to store it, as each stage sees it.
+	//clearing the depth buffer changes the range, like ClearDepthBuffer does.
+	std::vector<fp> depthscales(stages.size());
+	fp depthrange = graphics.depthrange;
+	bool cleardepth = false;
+	for (size_t i = 0; i < stages.size(); i++)
+	{
+		if (stages[i].type == stageClearDepth)
+		{
+			depthrange = stages[i].value;
+			cleardepth = true;
+		}
+		depthscales[i] = getDepthScale(graphics.depthformat, depthrange);
+	}
+	if (cleardepth && graphics.depthbuffer)
+	{
+		graphics.depthrange = depthrange;
+		if (graphics.hiz)
+		{
+			graphics.hiz->reset(depthrange);
+		}
+	}
+	cint width = graphics.width;
+	cint jobcount = (graphics.height + postrowsperjob - 1) / postrowsperjob;
+	graphics.dispatchDepthBuffer([&](auto* const depthptr, cfp& scale)
+		{
+			typedef std::remove_pointer_t<decltype(depthptr)> depthType;
+			getThreadPool(rendersettings::s3d::threadcount)->run(jobcount, [&](cint& index)
+				{
+					std::vector<int> weights(width);
+					cint endy = min((index + 1) * postrowsperjob, graphics.height);
+					for (int y = index * postrowsperjob; y < endy; y++)
+					{
+						color* const row = graphics.colors + y * width;
+						depthType* const depthrow = depthptr ? depthptr + y * width : nullptr;
+						for (size_t i = 0; i < stages.size(); i++)
+						{
+							const postStage& stage = stages[i];
+							switch (stage.type)
+							{
+							case stageClearColor:
+								std::fill(row, row + width, stage.c);
+								break;
+							case stageClearDepth:
+								if (depthrow)
+								{
+									std::fill(depthrow, depthrow + width, toStoredDepth<depthType>(stage.value * depthscales[i]));
+								}
+								break;
+							case stageFog:
+								if (depthrow)
+								{
+									getFogWeights(depthrow, width, stage.value / depthscales[i], weights.data());
+									blendRow(row, width, stage.c, weights.data());
+								}
+								break;
+							case stageFade:
+								//the weight is of the pixels, not of the color
+								blendRow(row, width, stage.c, nullptr, getFixedWeight(1 - stage.value));
+								break;
+							case stageMultiply:
+								blendRow(row, width, color(), nullptr, getFixedWeight(1 - stage.value));
+								break;
+							case stageCustom:
+								stage.function(graphics, row, y, stage.data);
+								break;
+							}
+						}
+					}
+				});
+		});
+}
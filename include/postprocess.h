@@ -0,0 +1,46 @@
+#pragma once
+#include "graphics.h"
+
+//the amount of rows a thread processes at once
+constexpr int postrowsperjob = 0x10;
+
+//the kinds of full screen passes
+enum postStageType
+{
+	stageClearColor,//set every pixel to a color, like graphicsObject::ClearColor
+	stageClearDepth,//set every depth to a distance, like graphicsObject::ClearDepthBuffer
+	stageFog,//blend the pixels to a color by their distance times a multiplier, like graphicsObject::Fog
+	stageFade,//blend the pixels from a color by a weight, like graphicsObject::Fade(weight, fadeto)
+	stageMultiply,//multiply the color channels by a value from 0 to 1, like graphicsObject::Fade(multiplier)
+	stageCustom,//call a function for every row
+};
+
+//changes the colors of row y of the screen. row: the first pixel of the row, data: the data of the stage
+typedef void(*postRowFunction)(const graphicsObject& graphics, color* row, cint& y, void* data);
+
+struct postStage
+{
+	postStageType type;
+	color c = color();
+	fp value = 0;
+	postRowFunction function = nullptr;
+	void* data = nullptr;
+};
+
+//full screen passes, applied in one sweep over the screen.
+//every stage is applied to a row before the next row is read, so the pixels are loaded from memory once for all stages.
+//the rows are split over rendersettings::s3d::threadcount threads.
+struct postProcess
+{
+	std::vector<postStage> stages;
+	void AddClearColor(const color& c);
+	void AddClearDepth(cfp& maxdistance = rendersettings::s3d::maxdistance);
+	void AddFog(const color& fogcolor, cfp& multiplier = 1.0 / rendersettings::s3d::maxdistance);
+	void AddFade(cfp& weight, const color& fadeto);
+	void AddMultiply(cfp& multiplier);
+	//the function can only change the colors of its row
+	void AddCustom(postRowFunction function, void* data = nullptr);
+	void Clear();
+	//applies the stages in the order they were added
+	void Apply(const graphicsObject& graphics) const;
+};
@@ -71,6 +71,18 @@ union rectangle2t
 			size.y = borders.pos00.y + borders.size.y - pos00.y;
 		}
 	}
+	//if the rectangles share any area
+	inline bool intersects(const rectangle2t& other) const
+	{
+		return x < other.x + other.w && other.x < x + w && y < other.y + other.h && other.y < y + h;
+	}
+	//the smallest rectangle containing both rectangles
+	inline rectangle2t united(const rectangle2t& other) const
+	{
+		const vec2t<t> newpos00 = vec2t<t>(min(x, other.x), min(y, other.y));
+		const vec2t<t> newpos11 = vec2t<t>(max(x + w, other.x + other.w), max(y + h, other.y + other.h));
+		return rectangle2t(newpos00, newpos11 - newpos00);
+	}
 	inline vec2t<t> centered(const vec2t<t>& innerRectSize) const
 	{
 		return vec2t<t>(
@@ -0,0 +1,101 @@
+#include "rectanglegrid.h"
+
+void rectangleGrid::build(const std::vector<rectangle2i>& rects)
+{
+	this->rects = rects;
+	bounds = rectangle2i();
+	bool first = true;
+	for (crectangle2i& rect : rects)
+	{
+		if (rect.w > 0 && rect.h > 0)
+		{
+			bounds = first ? rect : bounds.united(rect);
+			first = false;
+		}
+	}
+	cellcount = vec2i(
+		max((bounds.w + rectanglegridcellsize - 1) / rectanglegridcellsize, 1),
+		max((bounds.h + rectanglegridcellsize - 1) / rectanglegridcellsize, 1));
+	cells = std::vector<std::vector<int>>(cellcount.x * cellcount.y);
+	for (int index = 0; index < (int)rects.size(); index++)
+	{
+		insert(index);
+	}
+}
+
+bool rectangleGrid::move(cint& index, crectangle2i& rect)
+{
+	if (rect.w > 0 && rect.h > 0 &&
+		(rect.x < bounds.x || rect.y < bounds.y || rect.x + rect.w > bounds.x + bounds.w || rect.y + rect.h > bounds.y + bounds.h))
+	{
+		return false;
+	}
+	remove(index);
+	rects[index] = rect;
+	insert(index);
+	return true;
+}
+
+int rectangleGrid::find(cvec2i& pos) const
+{
+	if (!bounds.contains(pos))
+	{
+		return -1;
+	}
+	const std::vector<int>& cell = cells[(pos.x - bounds.x) / rectanglegridcellsize + ((pos.y - bounds.y) / rectanglegridcellsize) * cellcount.x];
+	for (auto it = cell.rbegin(); it != cell.rend(); it++)
+	{
+		if (rects[*it].contains(pos))
+		{
+			return *it;
+		}
+	}
+	return -1;
+}
+
+bool rectangleGrid::getCells(crectangle2i& rect, vec2i& mincell, vec2i& maxcell) const
+{
+	if (rect.w <= 0 || rect.h <= 0)
+	{
+		return false;
+	}
+	mincell = vec2i((rect.x - bounds.x) / rectanglegridcellsize, (rect.y - bounds.y) / rectanglegridcellsize);
+	maxcell = vec2i((rect.x + rect.w - 1 - bounds.x) / rectanglegridcellsize, (rect.y + rect.h - 1 - bounds.y) / rectanglegridcellsize);
+	return true;
+}
+
+void rectangleGrid::insert(cint& index)
+{
+	vec2i mincell, maxcell;
+	if (getCells(rects[index], mincell, maxcell))
+	{
+		for (int cy = mincell.y; cy <= maxcell.y; cy++)
+		{
+			for (int cx = mincell.x; cx <= maxcell.x; cx++)
+			{
+				std::vector<int>& cell = cells[cx + cy * cellcount.x];
+				cell.insert(std::lower_bound(cell.begin(), cell.end(), index), index);
+			}
+		}
+	}
+}
+
+void rectangleGrid::remove(cint& index)
+{
+	vec2i mincell, maxcell;
+	if (getCells(rects[index], mincell, maxcell))
+	{
+		for (int cy = mincell.y; cy <= maxcell.y; cy++)
+		{
+			for (int cx = mincell.x; cx <= maxcell.x; cx++)
+			{
+				std::vector<int>& cell = cells[cx + cy * cellcount.x];
+				const auto it = std::lower_bound(cell.begin(), cell.end(), index);
+				if (it != cell.end() && *it == index)
+				{
+					cell.erase(it);
+				}
+			}
+		}
+	}
+}
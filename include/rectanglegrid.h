@@ -0,0 +1,31 @@
+#include "rectangle2.h"
+#pragma once
+
+//the size of the cells of a rectangle grid in pixels
+constexpr int rectanglegridcellsize = 0x40;
+
+//a uniform grid over rectangles, to find the rectangles at a position without checking all of them.
+//the rectangles are stored by index and the cells keep the indices sorted,
+//so the highest index at a position can be found like when checking the rectangles from back to front.
+struct rectangleGrid
+{
+	//the area the cells cover, the bounds of all rectangles
+	rectangle2i bounds = rectangle2i();
+	vec2i cellcount = vec2i();
+	//the indices of the rectangles overlapping each cell, from low to high
+	std::vector<std::vector<int>> cells;
+	//the rectangle of every index, as it is stored in the cells
+	std::vector<rectangle2i> rects;
+
+	void build(const std::vector<rectangle2i>& rects);
+	//moves a rectangle to other cells.
+	//returns false when the rectangle does not fit in the bounds, then the grid has to be built again.
+	bool move(cint& index, crectangle2i& rect);
+	//the highest index with a rectangle containing pos, or -1
+	int find(cvec2i& pos) const;
+private:
+	//the first and last cell a rectangle overlaps. returns false for empty rectangles.
+	bool getCells(crectangle2i& rect, vec2i& mincell, vec2i& maxcell) const;
+	void insert(cint& index);
+	void remove(cint& index);
+};
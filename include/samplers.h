@@ -0,0 +1,277 @@
+#pragma once
+#include "squaretex.h"
+#include "texturefilter.h"
+
+//samplers read colors from a texture without calling the virtual getColor function,
+//so the fill loops can inline them. pick a sampler once per draw call, not per pixel.
+
+//how texture coordinates are converted to pixel positions
+enum textureAddressing
+{
+	addressPixels,//the coordinates are pixel positions (rendersettings::multsize = false)
+	addressScaled,//the coordinates from 0 to 1 are scaled to the size of the texture (rendersettings::multsize = true)
+	addressRepeat,//like addressScaled, but the coordinates repeat every 1 (rendersettings::Remaindering = true)
+};
+
+//the addressing mode selected by rendersettings::multsize and rendersettings::Remaindering
+inline textureAddressing getTextureAddressing()
+{
+	return rendersettings::multsize ? rendersettings::Remaindering ? addressRepeat : addressScaled : addressPixels;
+}
+
+//the pixel a texture coordinate is in, on a texture of w by h pixels
+template<textureAddressing addressing>
+inline vec2i getTexelPosition(cvec2& pos, cint& w, cint& h);
+template<>
+inline vec2i getTexelPosition<addressPixels>(cvec2& pos, cint& w, cint& h)
+{
+	return vec2i((int)pos.x, (int)pos.y);
+}
+template<>
+inline vec2i getTexelPosition<addressScaled>(cvec2& pos, cint& w, cint& h)
+{
+	return vec2i((int)(pos.x * w), (int)(pos.y * h));
+}
+template<>
+inline vec2i getTexelPosition<addressRepeat>(cvec2& pos, cint& w, cint& h)
+{
+	return vec2i((int)(math::Remainder1(pos.x) * w), (int)(math::Remainder1(pos.y) * h));
+}
+
+template<textureAddressing addressing>
+inline int getTextureIndex(cvec2& pos, cint& w, cint& h)
+{
+	const vec2i texel = getTexelPosition<addressing>(pos, w, h);
+	return texel.x + texel.y * w;
+}
+
+//the 2 texels to blend along an axis of a texture of size texels, and the weight of the second one from 0 to 0x100.
+//the centers of the texels are half a texel from their corners.
+//repeating textures wrap around, the others are clamped to their edges.
+template<textureAddressing addressing>
+inline void getBilinearTexels(cfp& coordinate, cint& size, int& texel0, int& texel1, int& weight)
+{
+	fp texel = (addressing == addressPixels ? coordinate : (addressing == addressRepeat ? math::Remainder1(coordinate) : coordinate) * size) - 0.5;
+	if (addressing != addressRepeat)
+	{
+		texel = math::minimum(math::maximum(texel, (fp)0), (fp)(size - 1));
+	}
+	cint fixed = (int)floor(texel * 0x100);
+	weight = fixed & 0xff;
+	texel0 = fixed >> 8;
+	texel1 = texel0 + 1;
+	if (addressing == addressRepeat)
+	{
+		if (texel0 < 0)
+		{
+			texel0 = size - 1;
+		}
+		if (texel1 >= size)
+		{
+			texel1 = 0;
+		}
+	}
+	else if (texel1 >= size)
+	{
+		texel1 = size - 1;
+	}
+}
+
+//blends the 4 texels around pos on a texture of width by height texels.
+//getTexel(x, y) reads a texel inside the texture.
+template<textureAddressing addressing, typename texelFunction>
+inline color sampleBilinear(cvec2& pos, cint& width, cint& height, texelFunction&& getTexel)
+{
+	int x0, x1, weightx, y0, y1, weighty;
+	getBilinearTexels<addressing>(pos.x, width, x0, x1, weightx);
+	getBilinearTexels<addressing>(pos.y, height, y0, y1, weighty);
+	return blendBilinear(getTexel(x0, y0), getTexel(x1, y0), getTexel(x0, y1), getTexel(x1, y1), weightx, weighty);
+}
+
+//reads colors[x + y * width], like graphicsObject::getColor and Image::getColor
+//trilinear filtering is bilinear, because there are no other levels.
+template<textureAddressing addressing, textureFilter filter = filterNearest>
+struct linearSampler
+{
+	const color* colors;
+	int width;
+	int height;
+	linearSampler(const Texture& tex) :colors(tex.colors), width(tex.width), height(tex.height) {}
+	inline color getColor(cvec2& pos) const
+	{
+		if (filter == filterNearest)
+		{
+			return colors[getTextureIndex<addressing>(pos, width, height)];
+		}
+		return sampleBilinear<addressing>(pos, width, height, [this](cint& x, cint& y)
+			{
+				return colors[x + y * width];
+			});
+	}
+};
+
+//reads the active level of a squaretex, like squaretex::getColor
+//swizzled: the levels are stored in z-order
+template<textureAddressing addressing, bool swizzled = false, textureFilter filter = filterNearest>
+struct squaretexSampler
+{
+	const color* colors;
+	int size;
+	//all levels of the texture, so selectMipLevel can switch to another level
+	const color* mipcolors;
+	int level;
+	//trilinear filtering: the level below the active level and how much of it is blended in, from 0 to 0x100
+	const color* lowercolors;
+	int lowersize;
+	int lowerweight;
+	squaretexSampler(const squaretex& tex) :squaretexSampler(tex.colors, tex.level) {}
+	squaretexSampler(const color* mipcolors, cint& level, cint& lowerweight = 0) :
+		colors(mipcolors + HeightIndexes[level]), size(BinarySequence[level]), mipcolors(mipcolors), level(level),
+		lowercolors(mipcolors + HeightIndexes[max(level - 1, 0)]), lowersize(BinarySequence[max(level - 1, 0)]), lowerweight(level ? lowerweight : 0) {}
+	//reads texel (x, y) of a level of size by size texels
+	static inline color getTexel(const color* levelcolors, cint& size, cint& x, cint& y)
+	{
+		return levelcolors[swizzled ? getMortonIndex(x, y) : x + y * size];
+	}
+	inline color getColor(cvec2& pos) const
+	{
+		if (filter == filterNearest)
+		{
+			const vec2i texel = getTexelPosition<addressing>(pos, size, size);
+			return getTexel(colors, size, texel.x, texel.y);
+		}
+		const color sample = sampleBilinear<addressing>(pos, size, size, [this](cint& x, cint& y)
+			{
+				return getTexel(colors, size, x, y);
+			});
+		if (filter == filterTrilinear && lowerweight)
+		{
+			//pixel coordinates are positions on the active level
+			const vec2 lowerpos = addressing == addressPixels ? pos * 0.5 : pos;
+			const color lowersample = sampleBilinear<addressing>(lowerpos, lowersize, lowersize, [this](cint& x, cint& y)
+				{
+					return getTexel(lowercolors, lowersize, x, y);
+				});
+			return blendColors(sample, lowersample, lowerweight);
+		}
+		return sample;
+	}
+};
+
+//returns the sampler to use for a triangle whose texture coordinates change by dx per pixel to the right and by dy per pixel down.
+//only samplers of mipmapped textures change.
+template<typename samplerType>
+inline const samplerType& selectMipLevel(const samplerType& sampler, cvec2& dx, cvec2& dy)
+{
+	return sampler;
+}
+//the level whose texels are closest to the size of a pixel, but never more detailed than the active level.
+//trilinear filtering blends in the level below by the rest of the level of detail.
+//pixel coordinates are positions on the active level, so they keep it.
+template<textureAddressing addressing, bool swizzled, textureFilter filter>
+inline squaretexSampler<addressing, swizzled, filter> selectMipLevel(const squaretexSampler<addressing, swizzled, filter>& sampler, cvec2& dx, cvec2& dy)
+{
+	if (addressing == addressPixels)
+	{
+		return sampler;
+	}
+	//the amount of texels of the active level a pixel covers along its longest side
+	cfp texels = sqrt(max(dx.lengthsquared(), dy.lengthsquared())) * sampler.size;
+	if (!(texels > 1))
+	{
+		return sampler;
+	}
+	//every level down halves the size. a pixel covering the whole texture gets the 1x1 level.
+	if (texels >= sampler.size)
+	{
+		return squaretexSampler<addressing, swizzled, filter>(sampler.mipcolors, 0);
+	}
+	cfp detail = log2(texels);
+	cint steps = (int)detail;
+	return squaretexSampler<addressing, swizzled, filter>(sampler.mipcolors, sampler.level - steps, (int)((detail - steps) * 0x100));
+}
+
+//for textures with their own getColor function
+struct virtualSampler
+{
+	const Texture& tex;
+	virtualSampler(const Texture& tex) :tex(tex) {}
+	inline color getColor(cvec2& pos) const
+	{
+		return tex.getColor(pos);
+	}
+};
+
+//returns the same color everywhere, the texture coordinates are not used
+struct solidColorSampler
+{
+	color c;
+	solidColorSampler(const color& c) :c(c) {}
+	inline color getColor(cvec2& pos) const
+	{
+		return c;
+	}
+};
+
+template<textureAddressing addressing, bool swizzled, typename samplerFunction>
+inline void dispatchSquaretexSampler(const squaretex& tex, samplerFunction&& function)
+{
+	switch (tex.filter)
+	{
+	case filterNearest:
+		function(squaretexSampler<addressing, swizzled>(tex));
+		break;
+	case filterBilinear:
+		function(squaretexSampler<addressing, swizzled, filterBilinear>(tex));
+		break;
+	default:
+		function(squaretexSampler<addressing, swizzled, filterTrilinear>(tex));
+		break;
+	}
+}
+
+template<textureAddressing addressing, typename samplerFunction>
+inline void dispatchAddressedSampler(const Texture& tex, samplerFunction&& function)
+{
+	switch (tex.getLayout())
+	{
+	case layoutLinear:
+		if (tex.filter == filterNearest)
+		{
+			function(linearSampler<addressing>(tex));
+		}
+		else
+		{
+			function(linearSampler<addressing, filterBilinear>(tex));
+		}
+		break;
+	case layoutMipmapped:
+		dispatchSquaretexSampler<addressing, false>((const squaretex&)tex, function);
+		break;
+	case layoutMipmappedMorton:
+		dispatchSquaretexSampler<addressing, true>((const squaretex&)tex, function);
+		break;
+	default:
+		function(virtualSampler(tex));
+		break;
+	}
+}
+
+//calls function(sampler) with the sampler that reads this texture the fastest,
+//using the addressing mode of the current rendersettings and the filter of the texture
+template<typename samplerFunction>
+inline void dispatchSampler(const Texture& tex, samplerFunction&& function)
+{
+	switch (getTextureAddressing())
+	{
+	case addressPixels:
+		dispatchAddressedSampler<addressPixels>(tex, function);
+		break;
+	case addressScaled:
+		dispatchAddressedSampler<addressScaled>(tex, function);
+		break;
+	default:
+		dispatchAddressedSampler<addressRepeat>(tex, function);
+		break;
+	}
+}
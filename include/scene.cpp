@@ -0,0 +1,175 @@
+#include "scene.h"
+
+void sceneObject::UpdateBounds()
+{
+	bounds = m ? m->getBounds().transformed(transform) : part->getBounds(transform);
+}
+
+void sceneObject::Draw(graphicsObject* graphics, const mat4x4& view, const vec3& position, const vec3& lookdirection) const
+{
+	const mat4x4 objectview = mat4x4::cross(view, transform);
+	if (m)
+	{
+		m->Draw(graphics, position, objectview, lookdirection);
+	}
+	else
+	{
+		part->Draw(graphics, objectview, fill, position, lookdirection);
+	}
+}
+
+void scene::Add(mesh* m, const mat4x4& transform)
+{
+	sceneObject object = sceneObject();
+	object.m = m;
+	object.transform = transform;
+	objects.push_back(object);
+	needsBuild = true;
+}
+
+void scene::Add(bodypart* part, const color* fill, const mat4x4& transform)
+{
+	sceneObject object = sceneObject();
+	object.part = part;
+	object.fill = fill;
+	object.transform = transform;
+	objects.push_back(object);
+	needsBuild = true;
+}
+
+void scene::Build()
+{
+	nodes.clear();
+	order = std::vector<int>(objects.size());
+	for (int i = 0; i < (int)objects.size(); i++)
+	{
+		order[i] = i;
+		objects[i].UpdateBounds();
+	}
+	if (objects.size())
+	{
+		BuildNode(0, (int)objects.size());
+	}
+	needsBuild = false;
+}
+
+int scene::BuildNode(cint& first, cint& count)
+{
+	cint index = (int)nodes.size();
+	nodes.push_back(bvhNode());
+	AABB bounds = objects[order[first]].bounds;
+	vec3 centermin = bounds.getCenter(), centermax = centermin;
+	for (int i = first + 1; i < first + count; i++)
+	{
+		const AABB& objectbounds = objects[order[i]].bounds;
+		bounds = AABB::combine(bounds, objectbounds);
+		cvec3 center = objectbounds.getCenter();
+		for (int axis = 0; axis < 3; axis++)
+		{
+			centermin.axis[axis] = math::minimum(centermin.axis[axis], center.axis[axis]);
+			centermax.axis[axis] = math::maximum(centermax.axis[axis], center.axis[axis]);
+		}
+	}
+	nodes[index].bounds = bounds;
+	nodes[index].first = first;
+	nodes[index].count = count;
+	nodes[index].rightchild = -1;
+	if (count > bvhleafsize)
+	{
+		//split the objects in halves along the axis their centers are spread out the most on
+		cvec3 spread = centermax - centermin;
+		cint axis = spread.x > spread.y ? (spread.x > spread.z ? 0 : 2) : (spread.y > spread.z ? 1 : 2);
+		cint half = count / 2;
+		std::nth_element(order.begin() + first, order.begin() + first + half, order.begin() + first + count, [this, axis](cint& a, cint& b)
+			{
+				return objects[a].bounds.getCenter().axis[axis] < objects[b].bounds.getCenter().axis[axis];
+			});
+		BuildNode(first, half);
+		cint rightchild = BuildNode(first + half, count - half);
+		nodes[index].rightchild = rightchild;
+	}
+	return index;
+}
+
+void scene::Refit()
+{
+	if (needsBuild)
+	{
+		Build();
+		return;
+	}
+	for (sceneObject& object : objects)
+	{
+		object.UpdateBounds();
+	}
+	RefitNodes();
+}
+
+void scene::RefitNodes()
+{
+	//the children come after their parents, so they are refitted first
+	for (int index = (int)nodes.size() - 1; index >= 0; index--)
+	{
+		bvhNode& node = nodes[index];
+		if (node.rightchild == -1)
+		{
+			node.bounds = objects[order[node.first]].bounds;
+			for (int i = node.first + 1; i < node.first + node.count; i++)
+			{
+				node.bounds = AABB::combine(node.bounds, objects[order[i]].bounds);
+			}
+		}
+		else
+		{
+			node.bounds = AABB::combine(nodes[index + 1].bounds, nodes[node.rightchild].bounds);
+		}
+	}
+}
+
+void scene::Draw(graphicsObject* graphics, const mat4x4& view, const vec3& position, const vec3& lookdirection)
+{
+	if (needsBuild)
+	{
+		Build();
+	}
+	drawncount = 0;
+	culledcount = 0;
+	if (nodes.empty())
+	{
+		return;
+	}
+	ViewFrustum frustum = ViewFrustum();
+	frustum.update(view);
+	std::vector<int> stack = std::vector<int>({ 0 });
+	while (stack.size())
+	{
+		cint index = stack.back();
+		stack.pop_back();
+		const bvhNode& node = nodes[index];
+		if (!frustum.isBoxInFrustum(node.bounds))
+		{
+			culledcount += node.count;
+		}
+		else if (node.rightchild == -1)
+		{
+			for (int i = node.first; i < node.first + node.count; i++)
+			{
+				const sceneObject& object = objects[order[i]];
+				if (frustum.isBoxInFrustum(object.bounds))
+				{
+					object.Draw(graphics, view, position, lookdirection);
+					drawncount++;
+				}
+				else
+				{
+					culledcount++;
+				}
+			}
+		}
+		else
+		{
+			stack.push_back(node.rightchild);
+			stack.push_back(index + 1);
+		}
+	}
+}
@@ -0,0 +1,57 @@
+#pragma once
+#include "mesh.h"
+#include "bodypart.h"
+
+//something a scene can draw: a mesh, or a tree of bodyparts
+struct sceneObject
+{
+	mesh* m = nullptr;
+	bodypart* part = nullptr;
+	const color* fill = nullptr;//the color of the bodyparts
+	mat4x4 transform;//from the space of the object to the space of the scene
+	AABB bounds;//the box around the object in the space of the scene
+	void UpdateBounds();
+	void Draw(graphicsObject* graphics, const mat4x4& view, const vec3& position, const vec3& lookdirection) const;
+};
+
+//the least amount of objects in a node of the bounding volume hierarchy before it is split
+constexpr int bvhleafsize = 4;
+
+//a node of the bounding volume hierarchy.
+//the left child comes right after its parent, so the children always come after their parents.
+struct bvhNode
+{
+	AABB bounds;
+	//the objects in this node and its children, indexes in scene::order
+	int first;
+	int count;
+	int rightchild;//-1 for leafs
+};
+
+//a collection of objects that are drawn together.
+//only the objects whose bounding boxes intersect the view frustum are drawn,
+//and a bounding volume hierarchy skips large groups of objects outside it at once.
+//https://en.wikipedia.org/wiki/Bounding_volume_hierarchy
+struct scene
+{
+	std::vector<sceneObject> objects;
+	//the indexes of the objects, sorted so the objects of a node are next to each other
+	std::vector<int> order;
+	std::vector<bvhNode> nodes;
+	//the amount of objects drawn and skipped by the last call to Draw
+	int drawncount = 0;
+	int culledcount = 0;
+	//the objects are not deleted by the scene
+	void Add(mesh* m, const mat4x4& transform = mat4x4());
+	void Add(bodypart* part, const color* fill, const mat4x4& transform = mat4x4());
+	//rebuilds the hierarchy. called by Draw when objects were added.
+	void Build();
+	//recalculates the bounds after objects moved or bodyparts were animated, without changing the hierarchy
+	void Refit();
+	//view: from the space of the scene to clip space
+	void Draw(graphicsObject* graphics, const mat4x4& view, const vec3& position, const vec3& lookdirection);
+private:
+	bool needsBuild = false;
+	int BuildNode(cint& first, cint& count);
+	void RefitNodes();
+};
@@ -0,0 +1,97 @@
+#pragma once
+#include "mat3x3.h"
+#include "mat4x4.h"
+#include "tilebinner.h"
+#include "threadpool.h"
+
+//the bones of a hierarchy stored in flat arrays, in topological order: a parent always comes before its children.
+//the world transforms are updated in one pass over the arrays, and only for bones that changed or whose parent changed.
+template<typename matrixType>
+struct skeletonT
+{
+	//the index of the parent of every bone, -1 for roots
+	std::vector<int> parents;
+	//from the space of a bone to the space of its parent
+	std::vector<matrixType> localtransforms;
+	//from the space of a bone to the space of the skeleton, valid after update
+	std::vector<matrixType> worldtransforms;
+	//the bones whose local transform changed since the last update
+	std::vector<byte> dirty;
+	bool anydirty = false;
+
+	//the parent has to be added before its children. returns the index of the new bone.
+	inline int addBone(cint& parent, const matrixType& localtransform)
+	{
+		parents.push_back(parent);
+		localtransforms.push_back(localtransform);
+		worldtransforms.push_back(localtransform);
+		dirty.push_back(true);
+		anydirty = true;
+		return (int)parents.size() - 1;
+	}
+	inline void setLocalTransform(cint& index, const matrixType& localtransform)
+	{
+		localtransforms[index] = localtransform;
+		dirty[index] = true;
+		anydirty = true;
+	}
+	inline int size() const
+	{
+		return (int)parents.size();
+	}
+	//recalculates the world transforms of the changed bones and their children
+	inline void update()
+	{
+		if (!anydirty)
+		{
+			return;
+		}
+		cint bonecount = size();
+		for (int i = 0; i < bonecount; i++)
+		{
+			cint parent = parents[i];
+			//the parent was updated before, so its flag is still set
+			if (parent != -1 && dirty[parent])
+			{
+				dirty[i] = true;
+			}
+			if (dirty[i])
+			{
+				worldtransforms[i] = parent == -1 ? localtransforms[i] : matrixType::cross(worldtransforms[parent], localtransforms[i]);
+			}
+		}
+		std::fill(dirty.begin(), dirty.end(), false);
+		anydirty = false;
+	}
+};
+
+typedef skeletonT<mat4x4> skeleton;
+typedef skeletonT<mat3x3> skeleton2d;
+
+//the least amount of skeletons updateSkeletons gives each thread at once
+constexpr int skeletonjobsize = 0x40;
+
+//updates many skeletons, for example of a crowd of characters, split over the renderer threads
+template<typename matrixType>
+inline void updateSkeletons(skeletonT<matrixType>* const* skeletons, cint& count)
+{
+	cint jobcount = (count + skeletonjobsize - 1) / skeletonjobsize;
+	if (rendersettings::s3d::threadcount > 1 && jobcount > 1)
+	{
+		getThreadPool(rendersettings::s3d::threadcount)->run(jobcount, [skeletons, count](cint& index)
+			{
+				cint end = min((index + 1) * skeletonjobsize, count);
+				for (int i = index * skeletonjobsize; i < end; i++)
+				{
+					skeletons[i]->update();
+				}
+			});
+	}
+	else
+	{
+		for (int i = 0; i < count; i++)
+		{
+			skeletons[i]->update();
+		}
+	}
+}
@@ -6,10 +6,9 @@ slider::slider(crectangle2i& rect, cfp& minValue, cfp& maxValue, cfp& value):Con
 	increaseButton = new button(rectangle2i(rect.w - buttonWidth, 0, buttonWidth, rect.h));
 	decreaseButton = new button(rectangle2i(0, 0, buttonWidth, rect.h));
 	dragButton = new button(rectangle2i(buttonWidth, 0, buttonWidth, rect.h));
-	childs->push_back(increaseButton);
-	childs->push_back(decreaseButton);
-	childs->push_back(dragButton);
-	childs->update();
+	addChild(increaseButton);
+	addChild(decreaseButton);
+	addChild(dragButton);
 
 	this->minValue = minValue;
 	this->maxValue = maxValue;
@@ -21,7 +20,7 @@ void slider::setValue(cfp& value)
 	//calculate the x position of the slider
 	cfp part = getw(minValue, maxValue, value);
 	int room = rect.w - decreaseButton->rect.w - dragButton->rect.w - increaseButton->rect.w;
-	dragButton->rect.x = decreaseButton->rect.w + part * room;
+	dragButton->setRect(rectangle2i(decreaseButton->rect.w + (int)(part * room), dragButton->rect.y, dragButton->rect.w, dragButton->rect.h));
 	this->value = value;
 }
 
@@ -33,7 +32,7 @@ void slider::onMouseDown(cvec2i& position)
 		//the background was clicked
 		int newDragButtonX = position.x - dragButton->rect.w / 2;
 		newDragButtonX = clamp(newDragButtonX, increaseButton->rect.w, rect.w - increaseButton->rect.w - dragButton->rect.w);
-		dragButton->rect.x = newDragButtonX;
+		dragButton->setRect(rectangle2i(newDragButtonX, dragButton->rect.y, dragButton->rect.w, dragButton->rect.h));
 		onDragCompleted();
 	}
 	else 
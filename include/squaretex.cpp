@@ -1,6 +1,6 @@
 #include "squaretex.h"
 //COPIES THE COLORS, NOT THE POINTER
-void squaretex::Load(color* colorptr, int w)
+void squaretex::Load(color* colorptr, int w, cbool& swizzle)
 {
 	res = 1;
 	for (int i = 1; i < w; i *= 2)
@@ -38,24 +38,41 @@ void squaretex::Load(color* colorptr, int w)
 			}
 		}
 	}
+	//the levels are averaged row by row first, then reordered
+	swizzled = swizzle;
+	if (swizzled)
+	{
+		color* linear = (color*)malloc(BinarySequence[res - 1] * BinarySequence[res - 1] * sizeof(color));
+		for (int i = 0; i < res; i++)
+		{
+			color* levelPtr = colors + HeightIndexes[i];
+			w = BinarySequence[i];
+			memcpy(linear, levelPtr, w * w * sizeof(color));
+			for (int y = 0; y < w; y++)
+			{
+				for (int x = 0; x < w; x++)
+				{
+					levelPtr[getMortonIndex(x, y)] = linear[x + y * w];
+				}
+			}
+		}
+		free(linear);
+	}
 }
 squaretex::squaretex()
 {
 	colors = NULL;
 }
-squaretex::squaretex(color* colorptr, int w)
+squaretex::squaretex(color* colorptr, int w, cbool& swizzle)
 {
-	Load(colorptr, w);
+	Load(colorptr, w, swizzle);
 }
 
 color squaretex::getColor(const vec2& pos) const
 {
 	cint w = BinarySequence[level];
+	cint x = rendersettings::multsize ? (int)((rendersettings::Remaindering ? math::Remainder1(pos.x) : pos.x) * w) : (int)pos.x;
+	cint y = rendersettings::multsize ? (int)((rendersettings::Remaindering ? math::Remainder1(pos.y) : pos.y) * w) : (int)pos.y;
 	return *(colors + HeightIndexes[level] + //index of current level
-		(rendersettings::multsize ?
-		((int)((rendersettings::Remaindering ? math::Remainder1(pos.x) : pos.x) * w) + //x
-			(int)((rendersettings::Remaindering ? math::Remainder1(pos.y) : pos.y) * w) * w) : //y
-			((int)pos.x + ((int)pos.y) * w)
-			)
-		);
+		(swizzled ? getMortonIndex(x, y) : x + y * w));
 }
\ No newline at end of file
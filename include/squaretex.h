@@ -1,6 +1,6 @@
 #pragma once
 #include "Texture.h"
-//max texture size: 64x64
+//the index of the first texel of every level. max texture size: 1024x1024
 constexpr int HeightIndexes[]{
 	0b0,//1x1
 	0b1,//2x2
@@ -13,15 +13,37 @@ constexpr int HeightIndexes[]{
 	0b101010101010101,//256x256
 	0b10101010101010101,//512x512
 	0b1010101010101010101,//1024x1024
+	0b101010101010101010101,//the end of the 1024x1024 level
 };
+//spreads the lower 16 bits of value over the even bits
+inline uint spreadBits(uint value)
+{
+	value &= 0xffff;
+	value = (value | (value << 8)) & 0x00ff00ff;
+	value = (value | (value << 4)) & 0x0f0f0f0f;
+	value = (value | (value << 2)) & 0x33333333;
+	value = (value | (value << 1)) & 0x55555555;
+	return value;
+}
+//the index of pixel (x, y) of a square texture in z-order: the bits of x and y interleaved.
+//pixels close to each other in any direction are close in memory, so rotated triangles read less cache lines.
+//https://en.wikipedia.org/wiki/Z-order_curve
+inline uint getMortonIndex(cint& x, cint& y)
+{
+	return spreadBits(x) | (spreadBits(y) << 1);
+}
+
 struct squaretex : public Texture
 {
 
 	int res;//the resolution steps of this texture
 	int level;//the resolution level for getcolor
-	void Load(color* colorptr, int w);
+	bool swizzled = false;//every level is stored in z-order instead of row by row. uses the same memory.
+	//swizzle: store the levels in z-order. every read costs an extra index calculation, so compare both layouts with the benchmark project before using it.
+	void Load(color* colorptr, int w, cbool& swizzle = false);
 	squaretex();
-	squaretex(color* colorptr, int w);
+	squaretex(color* colorptr, int w, cbool& swizzle = false);
 	color getColor(const vec2& pos) const;
+	virtual textureLayout getLayout() const override { return swizzled ? layoutMipmappedMorton : layoutMipmapped; }
 
 };
\ No newline at end of file
@@ -0,0 +1,42 @@
+#pragma once
+#include "GlobalFunctions.h"
+#include <intrin.h>
+
+//the weights of the filters are 8.8 fixed point: 0 is the first texel, 0x100 would be the second.
+
+//blends a to b by weight / 0x100.
+//all 4 channels are blended at once in 16 bit lanes.
+inline color blendColors(const color& a, const color& b, cint& weight)
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i channelsa = _mm_unpacklo_epi8(_mm_cvtsi32_si128(a.val), zero);
+	const __m128i channelsb = _mm_unpacklo_epi8(_mm_cvtsi32_si128(b.val), zero);
+	//at most 0xff * 0x100, so the sum fits in 16 bits unsigned
+	const __m128i blended = _mm_srli_epi16(_mm_add_epi16(
+		_mm_mullo_epi16(channelsa, _mm_set1_epi16((short)(0x100 - weight))),
+		_mm_mullo_epi16(channelsb, _mm_set1_epi16((short)weight))), 8);
+	color result;
+	result.val = _mm_cvtsi128_si32(_mm_packus_epi16(blended, blended));
+	return result;
+}
+
+//blends the 4 texels around a position.
+//weightx: how far the position is from c00 to c10, weighty: from c00 to c01.
+//the top and bottom rows are blended horizontally in the same register, then blended vertically.
+inline color blendBilinear(const color& c00, const color& c10, const color& c01, const color& c11, cint& weightx, cint& weighty)
+{
+	const __m128i zero = _mm_setzero_si128();
+	//the top texel in the low half, the bottom texel in the high half
+	const __m128i left = _mm_unpacklo_epi8(_mm_unpacklo_epi32(_mm_cvtsi32_si128(c00.val), _mm_cvtsi32_si128(c01.val)), zero);
+	const __m128i right = _mm_unpacklo_epi8(_mm_unpacklo_epi32(_mm_cvtsi32_si128(c10.val), _mm_cvtsi32_si128(c11.val)), zero);
+	const __m128i horizontal = _mm_srli_epi16(_mm_add_epi16(
+		_mm_mullo_epi16(left, _mm_set1_epi16((short)(0x100 - weightx))),
+		_mm_mullo_epi16(right, _mm_set1_epi16((short)weightx))), 8);
+	const __m128i bottom = _mm_srli_si128(horizontal, 8);
+	const __m128i vertical = _mm_srli_epi16(_mm_add_epi16(
+		_mm_mullo_epi16(horizontal, _mm_set1_epi16((short)(0x100 - weighty))),
+		_mm_mullo_epi16(bottom, _mm_set1_epi16((short)weighty))), 8);
+	color result;
+	result.val = _mm_cvtsi128_si32(_mm_packus_epi16(vertical, vertical));
+	return result;
+}
@@ -0,0 +1,101 @@
+#include "threadpool.h"
+
+threadPool::threadPool(cint& threadCount)
+{
+	this->threadCount = threadCount;
+	nextIndex = 0;
+	//the calling thread works too
+	for (int i = 1; i < threadCount; i++)
+	{
+		workers.push_back(std::thread(&threadPool::work, this));
+	}
+}
+
+threadPool::~threadPool()
+{
+	{
+		std::unique_lock<std::mutex> lock(jobMutex);
+		stopping = true;
+	}
+	wake.notify_all();
+	for (std::thread& worker : workers)
+	{
+		worker.join();
+	}
+}
+
+void threadPool::run(cint& jobCount, const std::function<void(cint& index)>& job)
+{
+	if (workers.size() == 0 || jobCount < 2)
+	{
+		for (int index = 0; index < jobCount; index++)
+		{
+			job(index);
+		}
+		return;
+	}
+	{
+		std::unique_lock<std::mutex> lock(jobMutex);
+		currentJob = &job;
+		this->jobCount = jobCount;
+		nextIndex = 0;
+		activeWorkers = (int)workers.size();
+		generation++;
+	}
+	wake.notify_all();
+	doJobs();
+	//wait for the workers to finish their last jobs
+	std::unique_lock<std::mutex> lock(jobMutex);
+	done.wait(lock, [this] { return activeWorkers == 0; });
+	currentJob = nullptr;
+}
+
+void threadPool::doJobs()
+{
+	for (int index = nextIndex++; index < jobCount; index = nextIndex++)
+	{
+		(*currentJob)(index);
+	}
+}
+
+void threadPool::work()
+{
+	ll handledGeneration = 0;
+	while (true)
+	{
+		{
+			std::unique_lock<std::mutex> lock(jobMutex);
+			wake.wait(lock, [&] { return stopping || generation != handledGeneration; });
+			if (stopping)
+			{
+				return;
+			}
+			handledGeneration = generation;
+		}
+		doJobs();
+		std::unique_lock<std::mutex> lock(jobMutex);
+		if (--activeWorkers == 0)
+		{
+			done.notify_one();
+		}
+	}
+}
+
+//the pool getThreadPool returns, created when needed
+threadPool* sharedPool = nullptr;
+
+threadPool* getThreadPool(cint& threadCount)
+{
+	if (!sharedPool || sharedPool->threadCount != threadCount)
+	{
+		delete sharedPool;
+		sharedPool = new threadPool(threadCount);
+	}
+	return sharedPool;
+}
+
+void DeleteThreadPool()
+{
+	delete sharedPool;
+	sharedPool = nullptr;
+}
@@ -0,0 +1,39 @@
+#pragma once
+#include "GlobalFunctions.h"
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include <thread>
+
+//a fixed set of worker threads that execute indexed jobs in parallel.
+//the calling thread helps out, so a pool of 1 thread runs everything on the calling thread.
+struct threadPool
+{
+	threadPool(cint& threadCount);
+	~threadPool();
+	//calls job(index) for every index from 0 to jobCount and returns when all jobs are done.
+	//jobs are picked in order, but can finish in any order.
+	//not reentrant: do not call run from inside a job.
+	void run(cint& jobCount, const std::function<void(cint& index)>& job);
+	int threadCount;
+private:
+	std::vector<std::thread> workers;
+	std::mutex jobMutex;
+	std::condition_variable wake;
+	std::condition_variable done;
+	const std::function<void(cint& index)>* currentJob = nullptr;
+	std::atomic<int> nextIndex;
+	int jobCount = 0;
+	int activeWorkers = 0;
+	ll generation = 0;//increases every run, so the workers know there is new work
+	bool stopping = false;
+	void doJobs();
+	void work();
+};
+
+//the pool shared by the renderer, recreated when the thread count changes.
+//only call this from the thread that owns the graphics.
+threadPool* getThreadPool(cint& threadCount);
+//stops and joins the workers of the shared pool. getThreadPool creates a new pool after this.
+void DeleteThreadPool();
@@ -0,0 +1,53 @@
+#include "tilebinner.h"
+
+int rendersettings::s3d::threadcount = max((int)std::thread::hardware_concurrency(), 1);
+
+void tileBinner::resize(cint& width, cint& height)
+{
+	this->width = width;
+	this->height = height;
+	tilesX = (width + rendersettings::s3d::tilesize - 1) / rendersettings::s3d::tilesize;
+	tilesY = (height + rendersettings::s3d::tilesize - 1) / rendersettings::s3d::tilesize;
+	tiles = std::vector<std::vector<int>>(tilesX * tilesY);
+	triangles.clear();
+}
+
+void tileBinner::add(const binnedTriangle& tri)
+{
+	//the bounding box of the triangle in tiles
+	cfp minx = min(min(tri.x[0], tri.x[1]), tri.x[2]);
+	cfp maxx = max(max(tri.x[0], tri.x[1]), tri.x[2]);
+	cint minTileX = minx > 0 ? (int)minx / rendersettings::s3d::tilesize : 0;
+	cint maxTileX = maxx < width ? (int)maxx / rendersettings::s3d::tilesize : tilesX - 1;
+	cint minTileY = tri.y[0] > 0 ? (int)tri.y[0] / rendersettings::s3d::tilesize : 0;
+	cint maxTileY = tri.y[2] < height ? (int)tri.y[2] / rendersettings::s3d::tilesize : tilesY - 1;
+	if (minTileX > maxTileX || minTileY > maxTileY)
+	{
+		return;
+	}
+	cint index = (int)triangles.size();
+	triangles.push_back(tri);
+	for (int tileY = minTileY; tileY <= maxTileY; tileY++)
+	{
+		for (int tileX = minTileX; tileX <= maxTileX; tileX++)
+		{
+			tiles[tileX + tileY * tilesX].push_back(index);
+		}
+	}
+}
+
+rectangle2i tileBinner::getTileRect(cint& index) const
+{
+	cint x = (index % tilesX) * rendersettings::s3d::tilesize;
+	cint y = (index / tilesX) * rendersettings::s3d::tilesize;
+	return rectangle2i(x, y, min(rendersettings::s3d::tilesize, width - x), min(rendersettings::s3d::tilesize, height - y));
+}
+
+void tileBinner::clear()
+{
+	triangles.clear();
+	for (std::vector<int>& tile : tiles)
+	{
+		tile.clear();
+	}
+}
@@ -0,0 +1,60 @@
+#pragma once
+#include "Texture.h"
+
+namespace rendersettings
+{
+	namespace s3d
+	{
+		//the width and height of a screen tile in pixels.
+		//triangle rows are split at tile borders, so the triangles fill the same pixels with and without binning.
+		constexpr int tilesize = 0x40;
+		//the amount of threads that fill the screen tiles. 1 fills every triangle directly on the calling thread.
+		extern int threadcount;
+	}
+}
+
+//the ways a binned triangle can be filled
+enum triangleShading
+{
+	shadingTexture,
+	shadingTextureLight,
+	shadingPlain,
+	shadingPlainLight
+};
+
+//a clipped triangle in window space
+//conditions:
+//y[0] <= y[1] <= y[2]
+struct binnedTriangle
+{
+	triangleShading shading;
+	fp x[3];
+	fp y[3];
+	fp d[3];
+	vec2 t[3];
+	vec3 l[3];
+	//the clip space w of the vertices, for perspective correct interpolation
+	fp w[3] = { 1, 1, 1 };
+	color c;
+	const Texture* tex = nullptr;
+};
+
+//sorts triangles into fixed screen tiles.
+//the tiles do not overlap, so they can be filled by different threads without locking.
+struct tileBinner
+{
+	int width = 0;
+	int height = 0;
+	int tilesX = 0;
+	int tilesY = 0;
+	//the amount of open batches. the bins are only flushed when no batch is open.
+	int batchDepth = 0;
+	std::vector<binnedTriangle> triangles;
+	//the indices of the triangles touching each tile, in the order they were added
+	std::vector<std::vector<int>> tiles;
+	void resize(cint& width, cint& height);
+	void add(const binnedTriangle& tri);
+	rectangle2i getTileRect(cint& index) const;
+	//removes the triangles, but keeps the memory for the next frame
+	void clear();
+};
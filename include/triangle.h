@@ -7,4 +7,6 @@ struct triangle
 	vec2 t[3];
 	vec3 screen[3];
 	vec3 light[3];
+	//the clip space w of the screen positions, for perspective correct interpolation
+	fp w[3];
 };
\ No newline at end of file
@@ -0,0 +1,208 @@
+#include "vertextransform.h"
+#include "tilebinner.h"
+#include "threadpool.h"
+
+simdKernel rendersettings::s3d::vertexkernel = getBestKernel();
+
+vertexKernelFunction getVertexKernel(const simdKernel& kernel)
+{
+	switch (kernel)
+	{
+	case kernelAVX2:
+		return vertexKernelAVX2;
+	case kernelSSE2:
+		return vertexKernelSSE2;
+	default:
+		return vertexKernelScalar;
+	}
+}
+
+void vertexKernelScalar(const mat4x4& view, const fp* vertices, cint& stride, cint& count, cfp& width, cfp& height, vec3* screen, fp* w)
+{
+	const fp* p3d = vertices;
+	for (int i = 0; i < count; i++, p3d += stride)
+	{
+		cfp x = p3d[0], y = p3d[1], z = p3d[2];
+		vec3 out = vec3(
+			x * view.m00 + y * view.m10 + z * view.m20 + view.m30,
+			x * view.m01 + y * view.m11 + z * view.m21 + view.m31,
+			x * view.m02 + y * view.m12 + z * view.m22 + view.m32
+		);
+		cfp vertexw = x * view.m03 + y * view.m13 + z * view.m23 + view.m33;
+		if (vertexw > 0)
+		{
+			out.x /= vertexw;
+			out.y /= vertexw;
+		}
+		out.x = (out.x * width + width) * .5;
+		out.y = (-out.y * height + height) * .5;//-y for byte alignment ( inverted)
+		screen[i] = out;
+		if (w)
+		{
+			w[i] = vertexw;
+		}
+	}
+}
+
+//the vertices are loaded component by component, so every lane of a register holds the same component of another vertex.
+//the results are stored in float arrays first and then converted to the vec3's.
+void vertexKernelSSE2(const mat4x4& view, const fp* vertices, cint& stride, cint& count, cfp& width, cfp& height, vec3* screen, fp* w)
+{
+	__m128 m[4][4];
+	for (int from = 0; from < 4; from++)
+	{
+		for (int to = 0; to < 4; to++)
+		{
+			m[from][to] = _mm_set1_ps((float)view.arr2d[from][to]);
+		}
+	}
+	const __m128 halfwidth = _mm_set1_ps((float)(width * .5)), halfheight = _mm_set1_ps((float)(height * .5));
+	const __m128 zero = _mm_setzero_ps();
+	float outx[4], outy[4], outz[4], outw[4];
+	int i = 0;
+	for (; i + 4 <= count; i += 4)
+	{
+		const fp* const p3d = vertices + i * stride;
+		const __m128 x = _mm_setr_ps((float)p3d[0], (float)p3d[stride], (float)p3d[stride * 2], (float)p3d[stride * 3]);
+		const __m128 y = _mm_setr_ps((float)p3d[1], (float)p3d[stride + 1], (float)p3d[stride * 2 + 1], (float)p3d[stride * 3 + 1]);
+		const __m128 z = _mm_setr_ps((float)p3d[2], (float)p3d[stride + 2], (float)p3d[stride * 2 + 2], (float)p3d[stride * 3 + 2]);
+		__m128 result[4];
+		for (int to = 0; to < 4; to++)
+		{
+			result[to] = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, m[0][to]), _mm_mul_ps(y, m[1][to])), _mm_add_ps(_mm_mul_ps(z, m[2][to]), m[3][to]));
+		}
+		//only divide by positive w's
+		const __m128 positive = _mm_cmpgt_ps(result[3], zero);
+		const __m128 dividedx = _mm_div_ps(result[0], result[3]), dividedy = _mm_div_ps(result[1], result[3]);
+		const __m128 projectedx = _mm_or_ps(_mm_and_ps(positive, dividedx), _mm_andnot_ps(positive, result[0]));
+		const __m128 projectedy = _mm_or_ps(_mm_and_ps(positive, dividedy), _mm_andnot_ps(positive, result[1]));
+		_mm_storeu_ps(outx, _mm_add_ps(_mm_mul_ps(projectedx, halfwidth), halfwidth));
+		_mm_storeu_ps(outy, _mm_sub_ps(halfheight, _mm_mul_ps(projectedy, halfheight)));
+		_mm_storeu_ps(outz, result[2]);
+		_mm_storeu_ps(outw, result[3]);
+		for (int lane = 0; lane < 4; lane++)
+		{
+			screen[i + lane] = vec3(outx[lane], outy[lane], outz[lane]);
+		}
+		if (w)
+		{
+			for (int lane = 0; lane < 4; lane++)
+			{
+				w[i + lane] = outw[lane];
+			}
+		}
+	}
+	if (i < count)
+	{
+		vertexKernelScalar(view, vertices + i * stride, stride, count - i, width, height, screen + i, w ? w + i : nullptr);
+	}
+}
+
+void vertexKernelAVX2(const mat4x4& view, const fp* vertices, cint& stride, cint& count, cfp& width, cfp& height, vec3* screen, fp* w)
+{
+	__m256 m[4][4];
+	for (int from = 0; from < 4; from++)
+	{
+		for (int to = 0; to < 4; to++)
+		{
+			m[from][to] = _mm256_set1_ps((float)view.arr2d[from][to]);
+		}
+	}
+	const __m256 halfwidth = _mm256_set1_ps((float)(width * .5)), halfheight = _mm256_set1_ps((float)(height * .5));
+	const __m256 zero = _mm256_setzero_ps();
+	float outx[8], outy[8], outz[8], outw[8];
+	float components[3][8];
+	int i = 0;
+	for (; i + 8 <= count; i += 8)
+	{
+		const fp* p3d = vertices + i * stride;
+		for (int lane = 0; lane < 8; lane++, p3d += stride)
+		{
+			components[0][lane] = (float)p3d[0];
+			components[1][lane] = (float)p3d[1];
+			components[2][lane] = (float)p3d[2];
+		}
+		const __m256 x = _mm256_loadu_ps(components[0]), y = _mm256_loadu_ps(components[1]), z = _mm256_loadu_ps(components[2]);
+		__m256 result[4];
+		for (int to = 0; to < 4; to++)
+		{
+			result[to] = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(x, m[0][to]), _mm256_mul_ps(y, m[1][to])), _mm256_add_ps(_mm256_mul_ps(z, m[2][to]), m[3][to]));
+		}
+		//only divide by positive w's
+		const __m256 positive = _mm256_cmp_ps(result[3], zero, _CMP_GT_OQ);
+		const __m256 projectedx = _mm256_blendv_ps(result[0], _mm256_div_ps(result[0], result[3]), positive);
+		const __m256 projectedy = _mm256_blendv_ps(result[1], _mm256_div_ps(result[1], result[3]), positive);
+		_mm256_storeu_ps(outx, _mm256_add_ps(_mm256_mul_ps(projectedx, halfwidth), halfwidth));
+		_mm256_storeu_ps(outy, _mm256_sub_ps(halfheight, _mm256_mul_ps(projectedy, halfheight)));
+		_mm256_storeu_ps(outz, result[2]);
+		_mm256_storeu_ps(outw, result[3]);
+		for (int lane = 0; lane < 8; lane++)
+		{
+			screen[i + lane] = vec3(outx[lane], outy[lane], outz[lane]);
+		}
+		if (w)
+		{
+			for (int lane = 0; lane < 8; lane++)
+			{
+				w[i + lane] = outw[lane];
+			}
+		}
+	}
+	if (i < count)
+	{
+		vertexKernelSSE2(view, vertices + i * stride, stride, count - i, width, height, screen + i, w ? w + i : nullptr);
+	}
+}
+
+void transformVertices(const mat4x4& view, const bufferobject<fp>* vertices, cint& width, cint& height, vec3* screen, fp* w)
+{
+	const vertexKernelFunction kernel = getVertexKernel(rendersettings::s3d::vertexkernel);
+	cint count = vertices->stepcount;
+	cint stride = vertices->stride;
+	cint jobcount = (count + rendersettings::s3d::vertexjobsize - 1) / rendersettings::s3d::vertexjobsize;
+	if (rendersettings::s3d::threadcount > 1 && jobcount > 1)
+	{
+		getThreadPool(rendersettings::s3d::threadcount)->run(jobcount, [&](cint& index)
+			{
+				cint start = index * rendersettings::s3d::vertexjobsize;
+				kernel(view, vertices->buffer + start * stride, stride, min(rendersettings::s3d::vertexjobsize, count - start), (fp)width, (fp)height, screen + start, w ? w + start : nullptr);
+			});
+	}
+	else
+	{
+		kernel(view, vertices->buffer, stride, count, (fp)width, (fp)height, screen, w);
+	}
+}
+
+void transformVerticesInstanced(const mat4x4* views, cint& instancecount, const bufferobject<fp>* vertices, cint& width, cint& height, vec3* screen, fp* w)
+{
+	if (instancecount == 1)
+	{
+		transformVertices(*views, vertices, width, height, screen, w);
+		return;
+	}
+	const vertexKernelFunction kernel = getVertexKernel(rendersettings::s3d::vertexkernel);
+	cint count = vertices->stepcount;
+	//small meshes are grouped, so every job transforms about vertexjobsize vertices
+	cint instancesperjob = max(1, rendersettings::s3d::vertexjobsize / max(1, count));
+	cint jobcount = (instancecount + instancesperjob - 1) / instancesperjob;
+	const auto transformInstances = [&](cint& firstinstance, cint& endinstance)
+	{
+		for (int instance = firstinstance; instance < endinstance; instance++)
+		{
+			cint offset = instance * count;
+			kernel(views[instance], vertices->buffer, vertices->stride, count, (fp)width, (fp)height, screen + offset, w ? w + offset : nullptr);
+		}
+	};
+	if (rendersettings::s3d::threadcount > 1 && jobcount > 1)
+	{
+		getThreadPool(rendersettings::s3d::threadcount)->run(jobcount, [&](cint& index)
+			{
+				transformInstances(index * instancesperjob, min((index + 1) * instancesperjob, instancecount));
+			});
+	}
+	else
+	{
+		transformInstances(0, instancecount);
+	}
+}
@@ -0,0 +1,34 @@
+#pragma once
+#include "mat4x4.h"
+#include "bufferobject.h"
+#include "cpufeatures.h"
+
+namespace rendersettings
+{
+	namespace s3d
+	{
+		//the kernel transformVertices uses. the best supported kernel by default.
+		//the simd kernels calculate in float, the scalar kernel in fp.
+		extern simdKernel vertexkernel;
+		//the amount of vertices a thread transforms at once. smaller meshes are transformed on the calling thread.
+		constexpr int vertexjobsize = 0x1000;
+	}
+}
+
+//transforms count vertices, stride fp's apart, to window space like graphicsObject::windowspace.
+//screen: the window space positions. x and y are divided by w when w > 0, z is not divided.
+//w: the clip space w of every vertex, or nullptr.
+typedef void(*vertexKernelFunction)(const mat4x4& view, const fp* vertices, cint& stride, cint& count, cfp& width, cfp& height, vec3* screen, fp* w);
+
+vertexKernelFunction getVertexKernel(const simdKernel& kernel);
+
+void vertexKernelScalar(const mat4x4& view, const fp* vertices, cint& stride, cint& count, cfp& width, cfp& height, vec3* screen, fp* w);
+void vertexKernelSSE2(const mat4x4& view, const fp* vertices, cint& stride, cint& count, cfp& width, cfp& height, vec3* screen, fp* w);
+void vertexKernelAVX2(const mat4x4& view, const fp* vertices, cint& stride, cint& count, cfp& width, cfp& height, vec3* screen, fp* w);
+
+//transforms all vertices of the buffer to a screen of width by height pixels,
+//split over the renderer threads when there are many
+void transformVertices(const mat4x4& view, const bufferobject<fp>* vertices, cint& width, cint& height, vec3* screen, fp* w = nullptr);
+//transforms all vertices of the buffer once for every view matrix. the vertices of instance i start at screen + i * vertices->stepcount.
+//the instances are split over the renderer threads when there are many vertices in total.
+void transformVerticesInstanced(const mat4x4* views, cint& instancecount, const bufferobject<fp>* vertices, cint& width, cint& height, vec3* screen, fp* w = nullptr);
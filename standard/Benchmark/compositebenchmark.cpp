@@ -0,0 +1,56 @@
+#include "compositebenchmark.h"
+#include "timemath.h"
+
+//the rows every kernel composites per blend mode, about 60 full hd frames
+constexpr int compositeRowCount = 0x10000;
+//the rows in the buffers. they are used over and over, so they stay in the cache like the rows of a texture and the screen would.
+constexpr int compositeBufferRows = 0x10;
+
+const wchar_t* blendModeNames[]{ L"copy", L"cutout", L"source over", L"premultiplied", L"additive", L"multiply" };
+const wchar_t* kernelNames[]{ L"scalar", L"sse2", L"avx2" };
+
+void benchmarkCompositing()
+{
+	cint pixelcount = compositeRowWidth * compositeBufferRows;
+	color* src = new color[pixelcount];
+	color* original = new color[pixelcount];
+	color* dst = new color[pixelcount];
+	for (int i = 0; i < pixelcount; i++)
+	{
+		//a quarter of the source pixels is transparent and a quarter is opaque, like a sprite
+		cint alpha = rand() % 4 == 0 ? 0 : rand() % 3 == 0 ? 0xff : rand() % 0x100;
+		src[i] = color(alpha, rand() % 0x100, rand() % 0x100, rand() % 0x100);
+		original[i] = color(rand() % 0x100, rand() % 0x100, rand() % 0x100, rand() % 0x100);
+	}
+	const simdKernel bestkernel = getBestKernel();
+	std::wcout << L"compositing " << compositeRowCount << L" rows of " << compositeRowWidth << L" pixels, in megapixels per second\n";
+	std::wcout << std::fixed << std::setprecision(0);
+	for (int mode = blendCopy; mode <= blendMultiply; mode++)
+	{
+		std::wcout << std::setw(16) << std::left << blendModeNames[mode] << std::right;
+		for (int kernel = kernelScalar; kernel <= kernelAVX2; kernel++)
+		{
+			std::wcout << L"  " << kernelNames[kernel] << L": ";
+			if (kernel > bestkernel)
+			{
+				std::wcout << L"unsupported";
+				continue;
+			}
+			const compositeFunction function = getCompositeKernel((blendMode)mode, (simdKernel)kernel);
+			//every kernel starts with the same pixels, so additive and multiply do not saturate sooner for one kernel
+			std::copy(original, original + pixelcount, dst);
+			const microseconds begin = getmicroseconds();
+			for (int row = 0; row < compositeRowCount; row++)
+			{
+				cint offset = (row % compositeBufferRows) * compositeRowWidth;
+				function(dst + offset, src + offset, compositeRowWidth);
+			}
+			const seconds duration = microsectosec(getmicroseconds() - begin);
+			std::wcout << std::setw(7) << (double)(compositeRowCount * (fp)compositeRowWidth / (duration * 1000000));
+		}
+		std::wcout << L"\n";
+	}
+	delete[] src;
+	delete[] original;
+	delete[] dst;
+}
@@ -0,0 +1,8 @@
+#pragma once
+#include "compositing.h"
+
+//the width of the rows the compositing benchmark combines, one row of a full hd screen
+constexpr int compositeRowWidth = 1920;
+
+//composites rows with every blend mode and every kernel this processor supports and prints the megapixels per second
+void benchmarkCompositing();
@@ -0,0 +1,10 @@
+#include "compositebenchmark.h"
+#include "texturebenchmark.h"
+
+//measures the speed of the drawing code. build and run it in release, the debug build does not inline the kernels.
+int main()
+{
+	benchmarkCompositing();
+	benchmarkTextureLayouts();
+	return 0;
+}
@@ -0,0 +1,87 @@
+#include "texturebenchmark.h"
+#include "timemath.h"
+
+//the times every quad is drawn with each layout
+constexpr int layoutDrawCount = 0x20;
+//the screen fits the quad at every angle
+constexpr int layoutScreenSize = 0x600;
+
+//how the quad is placed on the screen
+struct layoutCase
+{
+	const wchar_t* name;
+	fp angle;//the rotation in degrees
+	fp yscale;//the height of the quad relative to its width, below 1 the texture is read obliquely
+};
+
+const layoutCase layoutCases[]{
+	{ L"0 degrees", 0, 1 },
+	{ L"30 degrees", 30, 1 },
+	{ L"45 degrees", 45, 1 },
+	{ L"90 degrees", 90, 1 },
+	{ L"oblique 60 degrees", 60, 0.25 },
+};
+
+//draws the quad layoutDrawCount times and returns the megapixels per second
+fp measureFillRate(const graphicsObject& graphics, const squaretex& tex, const layoutCase& placement)
+{
+	//texel coordinates, one texel per pixel along the width of the quad
+	const vec2 texcorners[4]{ vec2(0, 0), vec2(layoutTextureSize, 0), vec2(layoutTextureSize, layoutTextureSize), vec2(0, layoutTextureSize) };
+	cfp radians = placement.angle * math::degtorad;
+	cfp c = cos(radians), s = sin(radians);
+	cfp center = layoutScreenSize * 0.5;
+	vec2 screencorners[4];
+	for (int i = 0; i < 4; i++)
+	{
+		const vec2 offset = vec2(texcorners[i].x - layoutTextureSize * 0.5, (texcorners[i].y - layoutTextureSize * 0.5) * placement.yscale);
+		screencorners[i] = vec2(center + offset.x * c - offset.y * s, center + offset.x * s + offset.y * c);
+	}
+	microseconds duration = 0;
+	for (int i = 0; i < layoutDrawCount; i++)
+	{
+		graphics.ClearDepthBuffer();
+		const microseconds begin = getmicroseconds();
+		graphics.fillTriangle3D(
+			screencorners[0].x, screencorners[0].y, 1, texcorners[0],
+			screencorners[1].x, screencorners[1].y, 1, texcorners[1],
+			screencorners[2].x, screencorners[2].y, 1, texcorners[2], tex);
+		graphics.fillTriangle3D(
+			screencorners[0].x, screencorners[0].y, 1, texcorners[0],
+			screencorners[2].x, screencorners[2].y, 1, texcorners[2],
+			screencorners[3].x, screencorners[3].y, 1, texcorners[3], tex);
+		duration += getmicroseconds() - begin;
+	}
+	cfp pixels = layoutTextureSize * (layoutTextureSize * placement.yscale) * layoutDrawCount;
+	return pixels / duration;
+}
+
+void benchmarkTextureLayouts()
+{
+	color* texturecolors = new color[layoutTextureSize * layoutTextureSize];
+	for (int i = 0; i < layoutTextureSize * layoutTextureSize; i++)
+	{
+		texturecolors[i] = color::RandomRGB();
+	}
+	squaretex rowmajor(texturecolors, layoutTextureSize, false);
+	squaretex morton(texturecolors, layoutTextureSize, true);
+	delete[] texturecolors;
+	graphicsObject graphics(layoutScreenSize, layoutScreenSize, true);
+	//touch the screen once, so the first measurement does not include the page faults
+	graphics.ClearColor(colorPalette::black);
+
+	std::wcout << L"filling a quad of " << layoutTextureSize << L"x" << layoutTextureSize << L" texels, in megapixels per second\n";
+	std::wcout << std::fixed << std::setprecision(0);
+	for (const layoutCase& placement : layoutCases)
+	{
+		cfp rowmajorrate = measureFillRate(graphics, rowmajor, placement);
+		cfp mortonrate = measureFillRate(graphics, morton, placement);
+		std::wcout << std::setw(20) << std::left << placement.name << std::right
+			<< L"  row by row: " << std::setw(5) << (double)rowmajorrate
+			<< L"  z-order: " << std::setw(5) << (double)mortonrate
+			<< L"  " << std::setprecision(2) << (double)(mortonrate / rowmajorrate) << L"x\n" << std::setprecision(0);
+	}
+	graphics.DeleteColors();
+	graphics.DeleteDepthBuffer();
+	free(rowmajor.colors);
+	free(morton.colors);
+}
@@ -0,0 +1,9 @@
+#pragma once
+#include "graphics.h"
+#include "squaretex.h"
+
+//the size of the texture the layout benchmark draws. 4 megabytes, so it does not fit in the cache.
+constexpr int layoutTextureSize = 0x400;
+
+//draws a rotated or oblique quad with the texture stored row by row and in z-order and prints the fill rate of both layouts
+void benchmarkTextureLayouts();